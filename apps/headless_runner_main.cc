@@ -0,0 +1,248 @@
+#include <core/domain_engine.h>
+#include <core/particle_engine.h>
+#include <core/scenario.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using idealgas::BroadphaseKind;
+using idealgas::DomainEngine;
+using idealgas::LocalSocketMesh;
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::Scenario;
+using idealgas::SpeciesId;
+using idealgas::SpeciesRegistry;
+using idealgas::StaticGeometry;
+using idealgas::Transport;
+
+namespace {
+
+void PrintUsage(const char* program) {
+  std::cerr << "usage: " << program
+            << " [--box <size>] [--particles <count>] [--steps <count>]"
+               " [--fps <rate>] [--serve <endpoint>] [--publish <name>]"
+               " [--ranks <count>] [--dt <time>] [--obstacles <file>]"
+               " [--broadphase grid|quadtree] [--scenario <file>]"
+               " [--seed <number>] [--resume <file>] [--checkpoint <file>]"
+            << std::endl;
+}
+
+/**
+ * Steps one rank of a domain decomposed run. Rank 0 reports the result.
+ */
+int RunRank(size_t box_size, size_t num_steps,
+            const std::vector<Particle>& particles, Transport* transport) {
+  DomainEngine domain(box_size, transport);
+  for (size_t index = 0; index < particles.size(); index++) {
+    domain.AddParticle(index, particles[index]);
+  }
+  for (size_t step = 0; step < num_steps; step++) {
+    if (!domain.Update()) {
+      std::cerr << "rank " << transport->GetRank()
+                << " lost a rank, or a particle moved half a slab in one step"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<std::pair<uint64_t, Particle>> gathered;
+  if (!domain.Gather(&gathered)) {
+    return 1;
+  }
+  if (transport->GetRank() == 0) {
+    std::cout << "ran " << num_steps << " steps on "
+              << transport->GetNumRanks() << " ranks with " << gathered.size()
+              << " particles" << std::endl;
+  }
+  return 0;
+}
+
+/**
+ * Forks one process per rank, each owning a slab of the box, and waits for
+ * them all to finish.
+ */
+int RunDecomposed(size_t box_size, size_t num_steps, size_t num_ranks,
+                  const std::vector<Particle>& particles) {
+  LocalSocketMesh mesh(num_ranks);
+  std::vector<pid_t> children;
+  for (size_t rank = 1; rank < num_ranks; rank++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      std::unique_ptr<Transport> transport = mesh.CreateTransport(rank);
+      _exit(RunRank(box_size, num_steps, particles, transport.get()));
+    }
+    children.push_back(pid);
+  }
+
+  std::unique_ptr<Transport> transport = mesh.CreateTransport(0);
+  int result = RunRank(box_size, num_steps, particles, transport.get());
+  for (pid_t pid : children) {
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      result = 1;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+// Runs a simulation without a window. Steps run forever unless --steps is
+// given, and are paced to --fps when it is not 0. With --ranks the box is
+// split between that many processes, which run as fast as they can. --dt sets
+// the time per step and switches to continuous collision detection, and
+// --broadphase picks how nearby particles are found. --scenario replaces the
+// box and the random particles with the initial state in a scenario file.
+// --seed fixes every random number, --resume continues from a checkpoint and
+// --checkpoint writes one after the last step.
+int main(int argc, char** argv) {
+  size_t box_size = 600;
+  size_t num_particles = 100;
+  size_t num_steps = 0;
+  size_t fps = 60;
+  std::string serve_endpoint;
+  std::string publish_name;
+  size_t num_ranks = 1;
+  float time_step = 0;
+  std::string obstacles_file;
+  BroadphaseKind broadphase = BroadphaseKind::kUniformGrid;
+  std::string scenario_file;
+  uint64_t seed = 0;
+  std::string resume_file;
+  std::string checkpoint_file;
+
+  for (int index = 1; index + 1 < argc; index += 2) {
+    std::string option = argv[index];
+    std::string value = argv[index + 1];
+    if (option == "--box") {
+      box_size = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (option == "--particles") {
+      num_particles = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (option == "--steps") {
+      num_steps = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (option == "--fps") {
+      fps = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (option == "--serve") {
+      serve_endpoint = value;
+    } else if (option == "--publish") {
+      publish_name = value;
+    } else if (option == "--ranks") {
+      num_ranks = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (option == "--dt") {
+      time_step = std::strtof(value.c_str(), nullptr);
+    } else if (option == "--obstacles") {
+      obstacles_file = value;
+    } else if (option == "--scenario") {
+      scenario_file = value;
+    } else if (option == "--seed") {
+      seed = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (option == "--resume") {
+      resume_file = value;
+    } else if (option == "--checkpoint") {
+      checkpoint_file = value;
+    } else if (option == "--broadphase" && value == "grid") {
+      broadphase = BroadphaseKind::kUniformGrid;
+    } else if (option == "--broadphase" && value == "quadtree") {
+      broadphase = BroadphaseKind::kQuadtree;
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  Scenario scenario;
+  if (!scenario_file.empty()) {
+    if (!scenario.Load(scenario_file)) {
+      std::cerr << "could not read a scenario from " << scenario_file
+                << std::endl;
+      return 1;
+    }
+    box_size = scenario.GetBoxSize();
+  }
+
+  ParticleEngine engine(box_size, seed);
+  engine.SetBroadphase(broadphase);
+  if (!scenario_file.empty()) {
+    scenario.Apply(&engine);
+  } else {
+    engine.GetSpeciesRegistry() = SpeciesRegistry::CreateDefault();
+    std::vector<SpeciesId> types = engine.GetSpeciesRegistry().GetIds();
+    for (size_t index = 0; index < num_particles; index++) {
+      engine.GenerateRandomParticle(types[index % types.size()]);
+    }
+  }
+
+  if (num_ranks > 1) {
+    if (num_steps == 0 || !serve_endpoint.empty() || !publish_name.empty() ||
+        time_step > 0 || !obstacles_file.empty() || !scenario_file.empty() ||
+        !resume_file.empty() || !checkpoint_file.empty()) {
+      std::cerr << "--ranks needs --steps and cannot serve, publish, set dt,"
+                   " load obstacles, load a scenario or use checkpoints"
+                << std::endl;
+      return 1;
+    }
+    return RunDecomposed(box_size, num_steps, num_ranks,
+                         engine.GetParticles());
+  }
+
+  if (!obstacles_file.empty()) {
+    std::ifstream scene(obstacles_file);
+    StaticGeometry geometry;
+    if (!scene || !geometry.Load(scene)) {
+      std::cerr << "could not read obstacles from " << obstacles_file
+                << std::endl;
+      return 1;
+    }
+    engine.SetStaticGeometry(geometry);
+  }
+  if (time_step > 0) {
+    engine.SetTimeStep(time_step);
+    engine.SetContinuousCollisions(true);
+  }
+  if (!resume_file.empty()) {
+    std::ifstream checkpoint(resume_file, std::ios::binary);
+    if (!engine.LoadCheckpoint(checkpoint)) {
+      std::cerr << "could not resume from " << resume_file << std::endl;
+      return 1;
+    }
+  }
+  if (!serve_endpoint.empty() && !engine.EnableFrameStreaming(serve_endpoint)) {
+    std::cerr << "could not stream frames on " << serve_endpoint << std::endl;
+    return 1;
+  }
+  if (!publish_name.empty() &&
+      !engine.EnableStatePublishing(publish_name,
+                                    engine.GetParticles().size())) {
+    std::cerr << "could not publish state to " << publish_name << std::endl;
+    return 1;
+  }
+
+  auto next_step = std::chrono::steady_clock::now();
+  for (size_t step = 0; num_steps == 0 || step < num_steps; step++) {
+    engine.Update();
+    if (fps != 0) {
+      next_step += std::chrono::microseconds(1000000 / fps);
+      std::this_thread::sleep_until(next_step);
+    }
+  }
+
+  if (!checkpoint_file.empty()) {
+    std::ofstream checkpoint(checkpoint_file, std::ios::binary);
+    if (!engine.SaveCheckpoint(checkpoint)) {
+      std::cerr << "could not write a checkpoint to " << checkpoint_file
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "ran " << engine.GetStepCount() << " steps" << std::endl;
+  return 0;
+}
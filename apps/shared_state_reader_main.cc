@@ -0,0 +1,39 @@
+#include <core/shared_state_reader.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+using idealgas::SharedStateReader;
+
+// Prints a short summary of a running simulation that publishes its state
+// with --publish, about once per second.
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <segment name>" << std::endl;
+    return 1;
+  }
+
+  SharedStateReader reader;
+  if (!reader.Open(argv[1])) {
+    std::cerr << "could not open shared state " << argv[1] << std::endl;
+    return 1;
+  }
+
+  SharedStateReader::Snapshot snapshot;
+  while (true) {
+    if (reader.Read(&snapshot)) {
+      double speed_sum = 0;
+      for (size_t index = 0; index < snapshot.velocity_x.size(); index++) {
+        speed_sum += std::hypot(snapshot.velocity_x[index],
+                                snapshot.velocity_y[index]);
+      }
+      size_t count = snapshot.velocity_x.size();
+      std::cout << "step " << snapshot.step << ": " << snapshot.total_count
+                << " particles, mean speed "
+                << (count == 0 ? 0 : speed_sum / count) << std::endl;
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "cinder/gl/gl.h"
+
+namespace idealgas {
+
+enum class BroadphaseKind { kUniformGrid, kQuadtree };
+
+/**
+ * Finds which axis aligned boxes overlap a query box without testing every
+ * box. Items are numbered from 0 and each has one box at a time.
+ */
+class Broadphase {
+ public:
+  virtual ~Broadphase() = default;
+
+  /**
+   * Creates an empty broadphase of one kind.
+   */
+  static std::unique_ptr<Broadphase> Create(BroadphaseKind kind);
+
+  /**
+   * Empties the broadphase.
+   * @param size The side length of the box the items are in, starting at the
+   * origin. Items outside it are still found.
+   * @param typical_size The side length of a typical item box, which
+   * broadphases with fixed cells use to size them.
+   * @param num_items Items are numbered from 0 to num_items - 1.
+   */
+  virtual void Reset(float size, float typical_size, size_t num_items) = 0;
+
+  /**
+   * Adds the box of an item that is not in the broadphase.
+   */
+  virtual void Insert(size_t item, const glm::vec2& min,
+                      const glm::vec2& max) = 0;
+
+  /**
+   * Removes an item.
+   */
+  virtual void Remove(size_t item) = 0;
+
+  /**
+   * Moves an item to a new box. This is cheaper than removing and inserting
+   * it when the box has not moved far.
+   */
+  virtual void Update(size_t item, const glm::vec2& min,
+                      const glm::vec2& max) = 0;
+
+  /**
+   * Appends each item whose box overlaps the query box, once.
+   * @param items Receives the items.
+   */
+  virtual void Query(const glm::vec2& min, const glm::vec2& max,
+                     std::vector<size_t>* items) = 0;
+};
+
+}  // namespace idealgas
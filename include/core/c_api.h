@@ -0,0 +1,154 @@
+/*
+ * A C interface to the particle engine, for driving simulations from other
+ * languages. Engines are opaque handles, and particle data is read in place
+ * through strided views instead of being copied out.
+ *
+ * Functions returning int return 1 on success and 0 on failure. Nothing
+ * here is safe to call on one engine from two threads at once, but separate
+ * engines are independent.
+ */
+#ifndef IDEALGAS_C_API_H_
+#define IDEALGAS_C_API_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(IDEALGAS_C_API_BUILD)
+#define IDEALGAS_API __declspec(dllexport)
+#else
+#define IDEALGAS_API __declspec(dllimport)
+#endif
+#else
+#define IDEALGAS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Raised whenever the functions or views change incompatibly. */
+#define IDEALGAS_API_VERSION 1
+
+typedef struct idealgas_engine idealgas_engine;
+
+/*
+ * Two floats per particle. Particle i's x is at
+ * (const float*)((const char*)data + i * stride) and its y follows it.
+ */
+typedef struct {
+  const float* data;
+  size_t count;
+  /* The distance in bytes from one particle's x to the next one's. */
+  size_t stride;
+} idealgas_vec2_view;
+
+/*
+ * One species id per particle, laid out like idealgas_vec2_view.
+ */
+typedef struct {
+  const uint16_t* data;
+  size_t count;
+  size_t stride;
+} idealgas_type_view;
+
+/* Matches the engine's thermostat kinds. */
+enum {
+  IDEALGAS_THERMOSTAT_NONE = 0,
+  IDEALGAS_THERMOSTAT_RESCALE = 1,
+  IDEALGAS_THERMOSTAT_BERENDSEN = 2,
+  IDEALGAS_THERMOSTAT_ANDERSEN = 3
+};
+
+IDEALGAS_API int idealgas_api_version(void);
+
+/*
+ * Creates an empty engine with the default species registered.
+ * box_size: The side length of the box in pixels.
+ * seed: Engines with the same seed and the same calls run identically.
+ */
+IDEALGAS_API idealgas_engine* idealgas_create(size_t box_size, uint64_t seed);
+
+/* Destroys an engine. NULL is ignored. */
+IDEALGAS_API void idealgas_destroy(idealgas_engine* engine);
+
+/*
+ * Advances the engine num_steps times in one call, so callers pay the call
+ * overhead once per batch rather than once per step.
+ */
+IDEALGAS_API void idealgas_step(idealgas_engine* engine, size_t num_steps);
+
+/*
+ * Adds count particles of a registered species at random positions.
+ * Returns 0, adding nothing, if the species is not registered.
+ */
+IDEALGAS_API int idealgas_spawn(idealgas_engine* engine, uint16_t type,
+                                size_t count);
+
+/*
+ * Adds one particle. A radius or mass of 0 is taken from the species.
+ * Returns 0, adding nothing, if the species is not registered.
+ */
+IDEALGAS_API int idealgas_add_particle(idealgas_engine* engine, float x,
+                                       float y, float vx, float vy,
+                                       float radius, float mass,
+                                       uint16_t type);
+
+/* Removes every particle and restarts the step count. */
+IDEALGAS_API void idealgas_clear(idealgas_engine* engine);
+
+/*
+ * Replaces the engine's particles, species, thermostats and obstacles with
+ * a scenario file's, scaled to the engine's box.
+ * Returns 0, leaving the engine unchanged, if the file cannot be loaded.
+ */
+IDEALGAS_API int idealgas_load_scenario(idealgas_engine* engine,
+                                        const char* path);
+
+/*
+ * Sets the time advanced by each step, and uses continuous collision
+ * detection if dt is positive. A dt of 0 restores the original steps of one
+ * unit of time with overlap based collisions.
+ */
+IDEALGAS_API void idealgas_set_time_step(idealgas_engine* engine, float dt);
+
+/*
+ * Holds one species at a target temperature.
+ * kind: One of the IDEALGAS_THERMOSTAT_ values.
+ * Returns 0 if the kind is unknown.
+ */
+IDEALGAS_API int idealgas_set_thermostat(idealgas_engine* engine,
+                                         uint16_t type, int kind,
+                                         float target_temperature,
+                                         float coupling);
+
+/*
+ * Writes or reads a checkpoint file, as ParticleEngine::SaveCheckpoint()
+ * and ParticleEngine::LoadCheckpoint() do.
+ */
+IDEALGAS_API int idealgas_save_checkpoint(const idealgas_engine* engine,
+                                          const char* path);
+IDEALGAS_API int idealgas_load_checkpoint(idealgas_engine* engine,
+                                          const char* path);
+
+IDEALGAS_API size_t idealgas_particle_count(const idealgas_engine* engine);
+IDEALGAS_API uint64_t idealgas_step_count(const idealgas_engine* engine);
+IDEALGAS_API float idealgas_temperature(const idealgas_engine* engine,
+                                        uint16_t type);
+
+/*
+ * Views of the engine's own particle storage. They are read only and stay
+ * valid until the next call that is passed the engine as non-const, which
+ * may move or reorder the particles; take new views after every step.
+ */
+IDEALGAS_API idealgas_vec2_view idealgas_positions(
+    const idealgas_engine* engine);
+IDEALGAS_API idealgas_vec2_view idealgas_velocities(
+    const idealgas_engine* engine);
+IDEALGAS_API idealgas_type_view idealgas_types(const idealgas_engine* engine);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* IDEALGAS_C_API_H_ */
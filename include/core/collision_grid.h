@@ -0,0 +1,48 @@
+#pragma once
+
+#include <core/broadphase.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * A uniform grid of square cells holding axis aligned boxes, used to find the
+ * boxes that overlap a query box without testing every box. Each box is listed
+ * in every cell it touches, and boxes past the edge of the grid go into the
+ * outermost cells.
+ */
+class CollisionGrid : public Broadphase {
+ public:
+  CollisionGrid();
+
+  /**
+   * Empties the grid and lays out cells over a square area, each as wide as
+   * typical_size. A typical_size of 0 gives a single cell.
+   */
+  void Reset(float size, float typical_size, size_t num_items) override;
+
+  void Insert(size_t item, const glm::vec2& min,
+              const glm::vec2& max) override;
+  void Remove(size_t item) override;
+  void Update(size_t item, const glm::vec2& min,
+              const glm::vec2& max) override;
+  void Query(const glm::vec2& min, const glm::vec2& max,
+             std::vector<size_t>* items) override;
+
+ private:
+  float cell_size_;
+  size_t cells_per_side_;
+  std::vector<std::vector<size_t>> cells_;
+  std::vector<glm::vec2> item_min_;
+  std::vector<glm::vec2> item_max_;
+
+  // An item is skipped by a query once its stamp matches the query's.
+  std::vector<size_t> item_stamps_;
+  size_t query_stamp_;
+
+  size_t GetCell(float coordinate) const;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <core/broadphase.h>
+#include <core/particle.h>
+#include <core/particle_engine.h>
+#include <core/transport.h>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * One process of a domain decomposed simulation. The box is split into
+ * vertical slabs of equal width, one per rank, and each rank only stores the
+ * particles whose centre lies in its slab. Every step, particles near a slab
+ * edge are copied to the neighbouring rank as halo particles so collisions
+ * across the edge are resolved on both sides, and particles that crossed an
+ * edge migrate to the neighbour.
+ *
+ * Particles carry a global id, and each rank resolves collisions in id order
+ * like a single ParticleEngine holding every particle in id order would. A
+ * particle's velocity after a step only depends on the particles it overlaps
+ * once moved, and on theirs in turn, so the halo is grown until each rank
+ * holds every such chain reaching one of its own particles. The results then
+ * match the single engine bit for bit, however densely particles collide.
+ */
+class DomainEngine {
+ public:
+  /**
+   * @param num_pixels_per_side The side length of the whole box.
+   * @param transport Connects this rank to the others. Not owned.
+   */
+  DomainEngine(const size_t& num_pixels_per_side, Transport* transport);
+
+  /**
+   * Adds a particle if its centre lies in this rank's slab. Every rank can be
+   * given the full initial state.
+   * @param id The particle's global id, unique across all ranks.
+   */
+  void AddParticle(uint64_t id, const Particle& particle);
+
+  /**
+   * Advances this rank by one step. Every rank must call this together.
+   * @return False on every rank if a rank is gone, or if a particle reaches
+   * half a slab width in one step, as chains could then skip a slab.
+   */
+  bool Update();
+
+  /**
+   * Collects every rank's particles on rank 0, sorted by id. Every rank must
+   * call this together.
+   * @param particles Receives all particles on rank 0. Left empty elsewhere.
+   * @return False if a rank is gone.
+   */
+  bool Gather(std::vector<std::pair<uint64_t, Particle>>* particles);
+
+  const std::vector<std::pair<uint64_t, Particle>>& GetParticles() const;
+
+  float GetSlabBegin() const;
+  float GetSlabEnd() const;
+
+ private:
+  Transport* transport_;
+  float slab_begin_;
+  float slab_end_;
+
+  // Owned particles, kept sorted by id.
+  std::vector<std::pair<uint64_t, Particle>> particles_;
+
+  // Runs the physics for the owned and halo particles of one step.
+  ParticleEngine engine_;
+
+  // A particle stepped on this rank, owned or from the halo.
+  struct LocalParticle {
+    uint64_t id;
+    Particle particle;
+    // The rank it came from, which is this rank for owned particles.
+    size_t source;
+    // Whether the lower and upper neighbours already have it.
+    bool sent_to_lower;
+    bool sent_to_upper;
+  };
+
+  std::vector<LocalParticle> local_;
+
+  // Reused between steps to find chains of overlapping local particles.
+  std::vector<glm::vec2> moved_positions_;
+  std::unique_ptr<Broadphase> broadphase_;
+  size_t num_indexed_;
+  std::vector<bool> in_chain_;
+  std::vector<size_t> chain_;
+  std::vector<size_t> candidates_;
+
+  /**
+   * How far a particle can reach into a neighbouring slab in one step: its
+   * radius plus the distance it moves.
+   */
+  static float GetReach(const Particle& particle);
+
+  /**
+   * Sends a neighbour the owned particles that could overlap one of its own
+   * after moving, and receives the neighbour's into local_.
+   * @param edge The x coordinate of the shared slab edge.
+   */
+  bool ExchangeHalo(size_t neighbour, float edge);
+
+  /**
+   * Sends a neighbour every indexed particle it does not have yet that will
+   * overlap, directly or through others, a particle it sent, and receives
+   * the neighbour's in return.
+   * @param sent Set to true if anything was sent.
+   */
+  bool ExchangeChains(size_t neighbour, bool* sent);
+
+  /**
+   * Puts every particle in local_ into the broadphase at the position the
+   * engine will move it to, where collisions are looked for.
+   */
+  void IndexLocalParticles();
+
+  /**
+   * Collects into chain_ the indexed particles that will overlap a particle
+   * from a neighbour, directly or through others.
+   */
+  void FindChains(size_t neighbour);
+
+  /**
+   * Combines flags from every rank, so all ranks make the same decision.
+   * @param combined Set to the bitwise or of every rank's flags.
+   */
+  bool CombineFlags(uint8_t flags, uint8_t* combined);
+
+  /**
+   * Appends received particles to local_, marked as having come from and
+   * being known to a neighbour.
+   */
+  void AddReceived(const std::vector<char>& bytes, size_t neighbour);
+
+  /**
+   * Sends owned particles that left the slab towards a neighbour and adds the
+   * particles the neighbour sends back.
+   */
+  bool ExchangeMigrants(size_t neighbour, bool towards_lower_ranks);
+
+  static void Serialize(const std::vector<std::pair<uint64_t, Particle>>& from,
+                        std::vector<char>* to);
+  static void Deserialize(const std::vector<char>& from,
+                          std::vector<std::pair<uint64_t, Particle>>* to);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <core/particle.h>
+#include <core/speed_distribution.h>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * Turns engine steps into compact frames for remote viewers. Positions are
+ * quantized to 16 bits per axis. A keyframe carries every particle in full,
+ * and the frames after it only carry each particle's offset from its
+ * keyframe position as a variable length integer. Deltas never depend on
+ * other deltas, so a viewer that misses frames can keep decoding as long as
+ * it has the keyframe.
+ */
+class FrameEncoder {
+ public:
+  explicit FrameEncoder(size_t keyframe_interval = 30);
+
+  /**
+   * Makes the next frame a keyframe, for example because a viewer joined.
+   */
+  void RequestKeyframe();
+
+  /**
+   * Encodes one step.
+   * @param particles The particles of the step.
+   * @param distributions The speed distribution of each particle type.
+   * @param step The step number.
+   * @param box_size The side length of the simulation box.
+   * @param frame Receives the encoded bytes.
+   * @return True if the frame is a keyframe.
+   */
+  bool Encode(const std::vector<Particle>& particles,
+              const std::map<SpeciesId, SpeedDistribution>& distributions,
+              size_t step, float box_size, std::vector<char>* frame);
+
+ private:
+  size_t keyframe_interval_;
+  size_t frames_since_keyframe_;
+  uint32_t keyframe_id_;
+  bool keyframe_requested_;
+  std::vector<uint16_t> keyframe_x_;
+  std::vector<uint16_t> keyframe_y_;
+};
+
+/**
+ * Rebuilds particles and histogram counts from frames made by FrameEncoder.
+ */
+class FrameDecoder {
+ public:
+  struct Frame {
+    uint64_t step;
+    float box_size;
+    bool is_keyframe;
+    std::vector<Particle> particles;
+    std::map<SpeciesId, std::vector<size_t>> histograms;
+  };
+
+  /**
+   * @param max_num_bins The most histogram bins a frame may carry for one
+   * type. Frames with more are refused, since their counts would not fit the
+   * sketches they are added to.
+   */
+  explicit FrameDecoder(
+      size_t max_num_bins = SpeedDistribution().GetNumBins());
+
+  /**
+   * @param bytes One encoded frame.
+   * @param frame Receives the decoded frame. It is left unchanged if the frame
+   * is refused.
+   * @return False if the frame is malformed, has too many histogram bins, or
+   * is a delta against a keyframe this decoder has not seen.
+   */
+  bool Decode(const std::vector<char>& bytes, Frame* frame);
+
+ private:
+  size_t max_num_bins_;
+  bool has_keyframe_;
+  uint32_t keyframe_id_;
+  float box_size_;
+  std::vector<uint16_t> keyframe_x_;
+  std::vector<uint16_t> keyframe_y_;
+  std::vector<Particle> keyframe_particles_;
+};
+
+}  // namespace idealgas
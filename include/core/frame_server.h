@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * Sends frames to any number of viewers over TCP or a Unix socket. Every
+ * socket is non-blocking and each viewer has a bounded queue, so a slow
+ * viewer only loses frames and never holds up the caller.
+ *
+ * Endpoints are written "host:port" for TCP, where port 0 picks a free port,
+ * or "unix:/path/to/socket".
+ */
+class FrameServer {
+ public:
+  /**
+   * @param max_queued_frames How many frames may wait for one viewer before
+   * it starts losing frames.
+   */
+  explicit FrameServer(size_t max_queued_frames = 8);
+  ~FrameServer();
+  FrameServer(const FrameServer&) = delete;
+  FrameServer& operator=(const FrameServer&) = delete;
+
+  /**
+   * Starts listening.
+   * @return False if the endpoint is malformed or cannot be bound.
+   */
+  bool Listen(const std::string& endpoint);
+
+  void Close();
+
+  /**
+   * The TCP port the server listens on, or 0 for Unix sockets.
+   */
+  uint16_t GetPort() const;
+
+  /**
+   * Accepts waiting viewers.
+   * @return True if a viewer is waiting for a keyframe, either because it
+   * just joined or because it lost frames.
+   */
+  bool AcceptClients();
+
+  size_t GetNumClients() const;
+
+  /**
+   * The number of frames that were dropped for slow viewers so far.
+   */
+  size_t GetDroppedFrames() const;
+
+  /**
+   * Queues a frame for every viewer and sends as much as the sockets take
+   * without blocking. Viewers that wait for a keyframe skip other frames.
+   */
+  void Broadcast(const std::vector<char>& frame, bool is_keyframe);
+
+ private:
+  struct Client {
+    int fd;
+    bool needs_keyframe;
+    std::deque<std::vector<char>> queue;
+
+    // How much of the front of the queue was already sent.
+    size_t offset;
+  };
+
+  size_t max_queued_frames_;
+  int listen_fd_;
+  std::string unix_path_;
+  uint16_t port_;
+  size_t dropped_frames_;
+  std::vector<Client> clients_;
+
+  /**
+   * Sends queued bytes until the socket would block.
+   * @return False if the viewer disconnected.
+   */
+  bool Flush(Client* client);
+};
+
+/**
+ * Receives frames sent by FrameServer.
+ */
+class FrameClient {
+ public:
+  FrameClient();
+  ~FrameClient();
+  FrameClient(const FrameClient&) = delete;
+  FrameClient& operator=(const FrameClient&) = delete;
+
+  /**
+   * Connects to a server. Uses the same endpoint format as FrameServer.
+   */
+  bool Connect(const std::string& endpoint);
+
+  void Close();
+
+  bool IsConnected() const;
+
+  /**
+   * Reads what has arrived without blocking.
+   * @param frame Receives the oldest complete frame not returned yet.
+   * @return True if a complete frame was returned.
+   */
+  bool Poll(std::vector<char>* frame);
+
+ private:
+  int fd_;
+  std::vector<char> buffer_;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * A pair potential between particles, cut off at a fixed distance and
+ * shifted so it is 0 there. Energies and forces are tabulated over the
+ * squared distance when the potential is made, so evaluating one costs a
+ * table lookup and no square root or pow call.
+ */
+class PairPotential {
+ public:
+  /**
+   * U(r) = 4 epsilon ((sigma / r)^12 - (sigma / r)^6), which repels at short
+   * range and attracts beyond 2^(1/6) sigma.
+   * @param epsilon The depth of the well.
+   * @param sigma The distance at which the potential is 0.
+   * @param cutoff The distance beyond which particles do not interact.
+   */
+  static PairPotential LennardJones(float epsilon, float sigma, float cutoff);
+
+  /**
+   * U(r) = strength exp(-r / screening_length) / r, a screened Coulomb
+   * potential. A negative strength attracts.
+   * @param strength The strength of the interaction.
+   * @param screening_length The distance over which it decays.
+   * @param cutoff The distance beyond which particles do not interact.
+   */
+  static PairPotential Yukawa(float strength, float screening_length,
+                              float cutoff);
+
+  float GetCutoff() const;
+
+  /**
+   * Returns the force between two particles divided by their distance, so the
+   * force on the first is this times the offset from the second to the
+   * first. Positive values repel.
+   * @param distance_squared The squared distance between the particles.
+   */
+  float GetForceOverDistance(float distance_squared) const;
+
+  /**
+   * Returns the potential energy of two particles.
+   * @param distance_squared The squared distance between the particles.
+   */
+  float GetEnergy(float distance_squared) const;
+
+ private:
+  static const size_t kTableSize = 4096;
+
+  float cutoff_;
+  float min_distance_squared_;
+  float cutoff_squared_;
+  float entries_per_unit_;
+  std::vector<float> force_table_;
+  std::vector<float> energy_table_;
+
+  /**
+   * Tabulates a potential from min_distance to cutoff.
+   * @param energy U(r), given r.
+   * @param force_over_distance -U'(r) / r, given r.
+   */
+  template <typename Energy, typename Force>
+  PairPotential(float min_distance, float cutoff, Energy energy,
+                Force force_over_distance);
+
+  float Lookup(const std::vector<float>& table, float distance_squared) const;
+};
+
+}  // namespace idealgas
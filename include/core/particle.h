@@ -1,18 +1,20 @@
 #pragma once
 
+#include <core/species_registry.h>
+
 #include "cinder/gl/gl.h"
 
 namespace idealgas {
 class Particle {
  public:
   Particle(glm::vec2 initial_pos, glm::vec2 initial_vel, float radius,
-           float mass, size_t type);
+           float mass, SpeciesId type);
 
   const glm::vec2& GetPosition() const;
   const glm::vec2& GetVelocity() const;
   const float& GetRadius() const;
   const float& GetMass() const;
-  const size_t& GetType() const;
+  const SpeciesId& GetType() const;
   void SetVelocity(const glm::vec2& vel);
 
   /**
@@ -21,11 +23,17 @@ class Particle {
    */
   void UpdatePosition();
 
+  /**
+   * Moves the particle along its velocity for a span of time.
+   * @param dt The time to move for.
+   */
+  void UpdatePosition(const float& dt);
+
  private:
   glm::vec2 position_;
   glm::vec2 velocity_;
   float radius_;
   float mass_;
-  size_t type_;
+  SpeciesId type_;
 };
 }  // namespace idealgas
\ No newline at end of file
@@ -1,25 +1,242 @@
 #pragma once
 
+#include <core/broadphase.h>
+#include <core/frame_codec.h>
+#include <core/frame_server.h>
+#include <core/pair_potential.h>
 #include <core/particle.h>
+#include <core/philox.h>
+#include <core/shared_state_publisher.h>
+#include <core/species_registry.h>
+#include <core/speed_distribution.h>
+#include <core/static_geometry.h>
+#include <core/thermostat.h>
+#include <core/time_series.h>
+
+#include <istream>
+#include <map>
+#include <memory>
+#include <ostream>
 
 #include "cinder/gl/gl.h"
 
 namespace idealgas {
 class ParticleEngine {
  public:
-  ParticleEngine(const size_t& num_pixels_per_side);
+  /**
+   * @param num_pixels_per_side The side length of the box.
+   * @param seed Every random number the engine draws follows from this, so
+   * engines with the same seed and the same calls run identically.
+   */
+  ParticleEngine(const size_t& num_pixels_per_side, uint64_t seed = 0);
   void Update();
 
+  /**
+   * Restarts the random numbers from a seed, as if the engine had been made
+   * with it.
+   */
+  void SetSeed(uint64_t seed);
+  const uint64_t& GetSeed() const;
+
+  /**
+   * Writes what a run needs to continue exactly as if it had not stopped:
+   * the seed and how far its random numbers have got, the step count, the
+   * timestep and every particle. Species, thermostats, obstacles, potentials
+   * and the broadphase are how the engine is set up, and are not written.
+   * @param output Receives the checkpoint.
+   * @return False if writing failed.
+   */
+  bool SaveCheckpoint(std::ostream& output) const;
+
+  /**
+   * Continues a run saved by SaveCheckpoint() in an engine set up like the
+   * one that saved it. The observable histories start again from here.
+   * @param input The checkpoint.
+   * @return False if it is malformed or for a box of another size, leaving
+   * the engine unchanged.
+   */
+  bool LoadCheckpoint(std::istream& input);
+
   /**
    * Creates a new particle with random position and velocity constrained by
    * the box size and particle radius.
    * @param radius The particle radius.
    */
   void GenerateRandomParticle(const float& radius, const float& mass,
-                              const size_t& type);
+                              const SpeciesId& type);
+
+  /**
+   * Creates a new particle of a registered species, with the species' mass
+   * and radius.
+   * @param type The species id.
+   */
+  void GenerateRandomParticle(const SpeciesId& type);
+
+  /**
+   * Sets the time advanced by each Update(). Velocities are in pixels per
+   * unit of time, so the default of 1 moves a particle by its velocity.
+   * @param dt The time per step.
+   */
+  void SetTimeStep(const float& dt);
+  const float& GetTimeStep() const;
+
+  /**
+   * Chooses how collisions are found. By default particles are moved and then
+   * tested for overlap, which misses contacts when a particle travels further
+   * than its diameter in one step. With continuous collisions every particle
+   * and wall contact inside the step is found at its exact time and resolved
+   * in time order, so large timesteps stay correct.
+   */
+  void SetContinuousCollisions(bool continuous_collisions);
+
+  /**
+   * Chooses how nearby particles are found. The uniform grid suits particles
+   * of similar size spread through the box. The quadtree adapts to the local
+   * density and to the particle size, for mixtures of very different radii
+   * or gases compressed into part of the box.
+   */
+  void SetBroadphase(BroadphaseKind kind);
+  BroadphaseKind GetBroadphase() const;
+
+  /**
+   * Makes particles interact through a pair potential instead of hard
+   * collisions. Particles are then moved by velocity Verlet integration and
+   * only bounce off the walls and obstacles. Neighbours within the cutoff are
+   * found with the broadphase.
+   * @param potential The potential between every pair of particles.
+   */
+  void SetPairPotential(const PairPotential& potential);
+
+  /**
+   * Goes back to hard collisions.
+   */
+  void ClearPairPotential();
+
+  /**
+   * Returns the total pair potential energy at the end of the last step, or
+   * 0 without a pair potential.
+   */
+  double GetPotentialEnergy() const;
+
+  /**
+   * Replaces the obstacles inside the box. The hierarchy over them is built
+   * here, once.
+   * @param geometry The obstacles.
+   */
+  void SetStaticGeometry(const StaticGeometry& geometry);
+  const StaticGeometry& GetStaticGeometry() const;
+
+  /**
+   * Holds one species at a target temperature from the next Update() on. A
+   * thermostat of kind kNone removes it.
+   * @param type The species.
+   * @param thermostat How to hold the temperature.
+   */
+  void SetThermostat(const SpeciesId& type, const Thermostat& thermostat);
+
+  /**
+   * Removes the thermostat of every species, registered or not.
+   */
+  void ClearThermostats();
+
+  /**
+   * Returns the thermostat of a species, of kind kNone if it has none.
+   */
+  const Thermostat& GetThermostat(const SpeciesId& type) const;
+
+  /**
+   * Multiplies the target temperature of every registered species. Species
+   * without a thermostat get one that starts from their current temperature,
+   * unless they have no particles or are at rest, since a target of 0 would
+   * stop every particle of theirs added later.
+   * @param factor The factor to multiply by.
+   */
+  void ScaleTargetTemperature(const float& factor);
+
+  /**
+   * Returns the mean kinetic energy per particle of one species, with
+   * Boltzmann's constant taken as 1. It is kept up to date as particles are
+   * added and stepped, without a pass over the particles.
+   */
+  float GetTemperature(const SpeciesId& type) const;
+
+  SpeciesRegistry& GetSpeciesRegistry();
+  const SpeciesRegistry& GetSpeciesRegistry() const;
+
+  /**
+   * Keeps particles sorted by species, so each species occupies one
+   * contiguous range of GetParticles(). Particles of one species keep their
+   * relative order.
+   */
+  void SetGroupBySpecies(bool group_by_species);
+
+  /**
+   * Returns the [begin, end) range of GetParticles() holding one species.
+   * Only valid while particles are grouped by species.
+   */
+  std::pair<size_t, size_t> GetSpeciesRange(const SpeciesId& type) const;
 
   const std::vector<Particle>& GetParticles() const;
 
+  /**
+   * Returns the speed distribution of one particle type. It is rebuilt at the
+   * end of every Update() and keeps a decayed time average across steps.
+   * @param type The particle type.
+   */
+  const SpeedDistribution& GetSpeedDistribution(const SpeciesId& type) const;
+
+  /**
+   * The number of times Update() has run since the last Clear().
+   */
+  size_t GetStepCount() const;
+
+  /**
+   * History of the mean kinetic energy per particle, with Boltzmann's
+   * constant taken as 1.
+   */
+  const TimeSeries& GetTemperatureHistory() const;
+
+  /**
+   * History of the number of particle collisions in each step.
+   */
+  const TimeSeries& GetCollisionRateHistory() const;
+
+  /**
+   * History of the number of particles.
+   */
+  const TimeSeries& GetParticleCountHistory() const;
+
+  /**
+   * Publishes every following step into a shared memory segment that other
+   * processes can map with SharedStateReader.
+   * @param name The segment name, starting with a slash.
+   * @param capacity The most particles a published step can hold.
+   * @return False if the segment could not be created.
+   */
+  bool EnableStatePublishing(const std::string& name, size_t capacity);
+
+  /**
+   * Stops publishing and removes the shared memory segment.
+   */
+  void DisableStatePublishing();
+
+  /**
+   * Streams every following step to remote viewers connecting to endpoint.
+   * See FrameServer for the endpoint format.
+   * @return False if the endpoint could not be bound.
+   */
+  bool EnableFrameStreaming(const std::string& endpoint);
+
+  /**
+   * Disconnects all viewers and stops streaming.
+   */
+  void DisableFrameStreaming();
+
+  /**
+   * Returns the frame server, or nullptr if streaming is disabled.
+   */
+  const FrameServer* GetFrameServer() const;
+
   /**
    * Clears all particles.
    */
@@ -32,21 +249,104 @@ class ParticleEngine {
   void AddParticle(const Particle& particle);
 
   /**
-   * Increases the velocity of every particle by 10%
+   * Adds many particles at once. When the engine is empty they are moved in
+   * rather than copied, so large initial states cost no extra copy.
+   * @param particles The particles to add, which is left empty.
    */
-  void AccelerateParticles();
+  void AddParticles(std::vector<Particle>* particles);
 
+ private:
   /**
-   * Decreases the velocity of every particle by 10%
+   * A predicted contact of a particle with another particle or a wall. It is
+   * stale once either particle has collided since the prediction.
    */
-  void DeaccelerateParticles();
+  struct CollisionEvent {
+    float time;
+    size_t particle1;
+    size_t particle2;
+    size_t count1;
+    size_t count2;
+    size_t obstacle;
+
+    bool operator>(const CollisionEvent& other) const;
+  };
+
+  // Stand-ins for particle2 when the event is a wall contact.
+  static const size_t kVerticalWall;
+  static const size_t kHorizontalWall;
+  static const size_t kObstacle;
+
+  // Widens broadphase boxes so rounding cannot hide a touching pair.
+  static const float kBroadphaseMargin;
+
+  // Bounds the events resolved in one step, since particles squeezed between
+  // each other can collide endlessly.
+  static const size_t kMaxEventsPerParticle = 32;
 
- private:
   size_t num_pixels_per_side_;
   std::vector<Particle> particles_;
+  float time_step_;
+  bool continuous_collisions_;
+  StaticGeometry geometry_;
+  std::vector<size_t> nearby_obstacles_;
+
+  std::unique_ptr<PairPotential> pair_potential_;
+  // The acceleration of each particle from the pair potential, kept from the
+  // end of one step for the start of the next until particles change.
+  std::vector<glm::vec2> accelerations_;
+  bool forces_valid_;
+  double potential_energy_;
+
+  // Reused between steps by the continuous collision pass.
+  std::vector<float> particle_times_;
+  std::vector<size_t> collision_counts_;
+  std::vector<CollisionEvent> events_;
+  std::vector<size_t> candidates_;
+
+  // Every random number the engine draws follows from this.
+  uint64_t seed_;
+  // Draws one after another for new particles.
+  PhiloxStream spawn_random_;
+  // Keyed by particle index and step for each thermostat draw.
+  Philox thermostat_random_;
+
+  // Finds nearby particles for every collision and force pass. It is kept
+  // between steps and rebuilt when particles are added, removed or reordered.
+  std::unique_ptr<Broadphase> broadphase_;
+  BroadphaseKind broadphase_kind_;
+  bool broadphase_valid_;
+  float broadphase_typical_size_;
+  std::vector<glm::vec2> box_min_;
+  std::vector<glm::vec2> box_max_;
+  std::vector<std::pair<size_t, size_t>> candidate_pairs_;
+  SpeciesRegistry species_;
+  bool group_by_species_;
+  std::map<SpeciesId, SpeedDistribution> speed_distributions_;
+  const SpeedDistribution kEmptySpeedDistribution;
+
+  struct SpeciesEnergy {
+    double kinetic_energy;
+    size_t num_particles;
+  };
+
+  std::map<SpeciesId, Thermostat> thermostats_;
+  const Thermostat kNoThermostat;
+  std::map<SpeciesId, SpeciesEnergy> species_energies_;
+  ThermostatPass thermostat_pass_;
+
+  size_t step_count_;
+  size_t step_collisions_;
+  TimeSeries temperature_history_;
+  TimeSeries collision_rate_history_;
+  TimeSeries particle_count_history_;
+  std::unique_ptr<SharedStatePublisher> state_publisher_;
+  std::unique_ptr<FrameServer> frame_server_;
+  FrameEncoder frame_encoder_;
+  std::vector<char> frame_;
 
   /**
-   * Calculates the new velocity of a particle post collision.
+   * Calculates the new velocity of a particle post collision, using the
+   * restitution registered for the two species.
    * @param particle1 The first particle.
    * @param particle2 The second particle.
    * @return A vector that returns the new velocity of particle1.
@@ -61,11 +361,32 @@ class ParticleEngine {
   void UpdateVelOnWallCollision();
 
   /**
-   * Checks every possible pair of particles and whether they have collided.
-   * Modifies velocity accordingly using a formula.
+   * Reflects each particle that touches an obstacle and is moving into it.
+   * Only the obstacles whose bounding boxes overlap the particle are tested.
+   */
+  void UpdateVelOnObstacleCollision();
+
+  /**
+   * Reflects the velocity of a particle off the surface of an obstacle it
+   * touches, if it is moving into it.
+   */
+  void ReflectOffObstacle(Particle& particle, const Obstacle& obstacle) const;
+
+  /**
+   * Checks every pair of particles that the broadphase finds overlapping and
+   * whether they have collided. Modifies velocity accordingly using a
+   * formula.
    */
   void UpdateVelOnParticleCollision();
 
+  /**
+   * Brings the broadphase up to date with the boxes in box_min_ and
+   * box_max_. Boxes are moved in place while the particles stay the same, and
+   * the broadphase is rebuilt otherwise.
+   * @param typical_size The side length of a typical box.
+   */
+  void RefreshBroadphase(float typical_size);
+
   /**
    * Helper method that takes two particles and determines if they will collide.
    *
@@ -75,5 +396,87 @@ class ParticleEngine {
    */
   bool WillParticlesCollide(const Particle& particle1,
                             const Particle& particle2) const;
+
+  /**
+   * Works out this step's thermostat adjustments from the tracked species
+   * energies. The adjustments are applied in the first pass over the
+   * particles.
+   */
+  void PrepareThermostats();
+
+  /**
+   * Advances every particle by one timestep with velocity Verlet, using the
+   * forces of the pair potential.
+   */
+  void UpdateWithPairPotential();
+
+  /**
+   * Computes the acceleration of every particle and the potential energy,
+   * visiting only the pairs within the cutoff.
+   */
+  void ComputeForces();
+
+  /**
+   * Advances every particle by one timestep, resolving each particle and wall
+   * contact at the moment it happens.
+   */
+  void UpdateWithContinuousCollisions();
+
+  /**
+   * Fills the broadphase with the path of every particle over the step
+   * and predicts their first contacts. Only pairs whose swept boxes overlap
+   * get an exact contact time.
+   */
+  void PredictInitialCollisions();
+
+  /**
+   * Replaces the path of a particle in the broadphase after its velocity
+   * changed, and predicts its next contacts with the walls and with the
+   * particles whose paths it crosses.
+   * @param index The particle.
+   * @param time The current time within the step.
+   */
+  void PredictCollisions(size_t index, float time);
+
+  /**
+   * Returns the box covering the path of a particle from its current time to
+   * the end of the step.
+   */
+  void GetSweptBox(size_t index, glm::vec2* min, glm::vec2* max) const;
+
+  /**
+   * Queues the first wall contact of a particle before the end of the step.
+   */
+  void PredictWallCollision(size_t index, float time);
+
+  /**
+   * Queues the first obstacle contact of a particle before the end of the
+   * step, testing only the obstacles near its path.
+   */
+  void PredictObstacleCollision(size_t index, float time);
+
+  /**
+   * Queues the contact of two particles if it happens before the end of the
+   * step.
+   */
+  void PredictParticleCollision(size_t index1, size_t index2, float time);
+
+  /**
+   * Moves a particle forward to a time within the step.
+   */
+  void AdvanceParticle(size_t index, float time);
+
+  /**
+   * Records the speed of every particle into the distribution of its type,
+   * totals the kinetic energy of each species and appends this step's
+   * observables to their histories, in a single pass.
+   */
+  void RecordObservables();
+
+  /**
+   * Encodes the current step and sends it to connected viewers. Does nothing
+   * when nobody is watching.
+   */
+  void StreamFrame();
 };
 }  // namespace idealgas
\ No newline at end of file
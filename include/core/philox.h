@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "cinder/gl/gl.h"
+
+namespace idealgas {
+
+/**
+ * The Philox4x32-10 counter based generator. Ten rounds keyed by a 64 bit
+ * key turn each 128 bit counter into four random words, so a draw can be
+ * made for any counter directly, in any order and on any thread, and is the
+ * same on every run. Draws are usually counted by what they are for, like a
+ * particle and a step, rather than by how many came before.
+ */
+class Philox {
+ public:
+  typedef std::array<uint32_t, 4> Block;
+
+  explicit Philox(uint64_t key = 0);
+
+  const uint64_t& GetKey() const;
+
+  /**
+   * Returns the four random words for one counter.
+   * @param first The low half of the counter.
+   * @param second The high half of the counter.
+   */
+  Block Generate(uint64_t first, uint64_t second) const;
+
+  /**
+   * Returns a generator whose words are independent of this one's, so each
+   * kind of draw or each thread can count from 0 without reusing words.
+   * @param purpose Distinguishes the split generators of one generator.
+   */
+  Philox Split(uint64_t purpose) const;
+
+  /**
+   * Returns a float in [0, 1) from one random word.
+   */
+  static float ToFloat(uint32_t bits);
+
+  /**
+   * Returns two independent standard normal numbers from two random words.
+   */
+  static glm::vec2 ToGaussians(uint32_t first, uint32_t second);
+
+ private:
+  uint64_t key_;
+};
+
+/**
+ * Draws random numbers one after another from a Philox generator. The whole
+ * state is the generator's key and the number of words drawn, so it can be
+ * saved and restored exactly.
+ */
+class PhiloxStream {
+ public:
+  explicit PhiloxStream(const Philox& generator = Philox());
+
+  uint32_t NextBits();
+
+  /**
+   * Returns a float in [min, max).
+   */
+  float NextFloat(float min, float max);
+
+  /**
+   * The number of words drawn so far.
+   */
+  const uint64_t& GetPosition() const;
+
+  /**
+   * Continues from a position returned by GetPosition().
+   */
+  void SetPosition(uint64_t position);
+
+ private:
+  Philox generator_;
+  uint64_t position_;
+  Philox::Block block_;
+};
+
+}  // namespace idealgas
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <core/broadphase.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * A loose quadtree. Every item is kept in the deepest node whose square,
+ * grown by half in size, contains its box, so large items sit near the root and
+ * small ones deep down. Nodes split when they hold too many items and merge
+ * back when their subtree empties, so cells follow the local density. The
+ * tree is kept between steps, and an item that moves within its node only has
+ * its box replaced.
+ */
+class Quadtree : public Broadphase {
+ public:
+  Quadtree();
+
+  void Reset(float size, float typical_size, size_t num_items) override;
+  void Insert(size_t item, const glm::vec2& min,
+              const glm::vec2& max) override;
+  void Remove(size_t item) override;
+  void Update(size_t item, const glm::vec2& min,
+              const glm::vec2& max) override;
+  void Query(const glm::vec2& min, const glm::vec2& max,
+             std::vector<size_t>* items) override;
+
+  /**
+   * The number of nodes in use, including the root.
+   */
+  size_t GetNumNodes() const;
+
+  /**
+   * The depth of the deepest node in use, where the root has depth 0.
+   */
+  size_t GetDepth() const;
+
+ private:
+  // Boxes are kept beside their items so a query reads each node's memory
+  // only.
+  struct Entry {
+    glm::vec2 min;
+    glm::vec2 max;
+    size_t item;
+  };
+
+  struct Node {
+    glm::vec2 center;
+    float half_size;
+    uint32_t parent;
+    // The first of four consecutive children, or kNone for a leaf.
+    uint32_t children;
+    uint32_t depth;
+    size_t subtree_count;
+    std::vector<Entry> entries;
+  };
+
+  static const uint32_t kNone;
+
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> free_groups_;
+  size_t num_nodes_;
+  std::vector<uint32_t> item_node_;
+  std::vector<uint32_t> item_slot_;
+  std::vector<uint32_t> pending_;
+
+  /**
+   * True if a box with this center and half extent belongs in the node or
+   * below it.
+   */
+  bool Fits(uint32_t node, const glm::vec2& center, float extent) const;
+
+  /**
+   * Returns the child of a split node whose square holds a point.
+   */
+  uint32_t GetChild(uint32_t node, const glm::vec2& point) const;
+
+  /**
+   * Adds an item to one node and counts it in every ancestor.
+   */
+  void AddToNode(uint32_t node, const Entry& entry);
+
+  /**
+   * Splits a leaf into four and moves down the items that fit a child.
+   */
+  void Split(uint32_t node);
+
+  /**
+   * Moves every item below a node into it and frees its descendants.
+   */
+  void Collapse(uint32_t node);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <core/particle.h>
+#include <core/particle_engine.h>
+#include <core/species_registry.h>
+#include <core/static_geometry.h>
+#include <core/thermostat.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * An initial state read from a file: a text header describing the box, then a
+ * table of particles. Header lines are
+ *
+ *   box <size>
+ *   species <id> <name> <mass> <radius> <red> <green> <blue>
+ *   restitution <id> <id> <coefficient>
+ *   thermostat <id> rescale|berendsen|andersen <target> [coupling]
+ *   segment <x1> <y1> <x2> <y2> [thickness]
+ *   circle <x> <y> <radius>
+ *
+ * with # starting a comment. Without species lines the default species are
+ * used. A restitution line may only name species declared above it. The
+ * header ends with the line that starts the particle table, one of
+ *
+ *   particles csv
+ *   particles binary <count>
+ *
+ * A CSV table has one "x,y,vx,vy,type[,radius,mass]" line per particle,
+ * where a missing radius and mass are taken from the species. A binary table
+ * follows directly after its line, with one 28 byte record per particle: x,
+ * y, vx, vy, radius and mass as 32 bit floats and the type as a 32 bit
+ * unsigned integer, in little endian byte order. A radius or mass of 0 is
+ * taken from the species.
+ */
+class Scenario {
+ public:
+  Scenario();
+
+  /**
+   * Reads a scenario, replacing the one held. The file is mapped rather than
+   * read, and the particle table is split into chunks that are parsed on
+   * every core, straight into the particles that are handed to the engine.
+   * @param path The file to read.
+   * @return False if the file could not be read or is malformed.
+   */
+  bool Load(const std::string& path);
+
+  size_t GetBoxSize() const;
+  const SpeciesRegistry& GetSpeciesRegistry() const;
+  const std::map<SpeciesId, Thermostat>& GetThermostats() const;
+  const StaticGeometry& GetStaticGeometry() const;
+  const std::vector<Particle>& GetParticles() const;
+
+  /**
+   * Scales the scenario to fill a box of another size. Positions, particle
+   * and species radii, obstacles and velocities all scale by the ratio of
+   * the boxes, so crossing times and collision rates are unchanged.
+   * Thermostat targets scale by its square, since temperatures go as the
+   * square of speeds.
+   * @param box_size The side length of the new box.
+   */
+  void ScaleTo(size_t box_size);
+
+  /**
+   * Replaces an engine's species, thermostats and obstacles with the
+   * scenario's and adds its particles. Every thermostat the engine had is
+   * removed, including those of species it never registered. The particles are moved rather than
+   * copied, so the scenario has none left afterwards.
+   * @param engine An engine whose box is GetBoxSize() pixels wide.
+   */
+  void Apply(ParticleEngine* engine);
+
+ private:
+  size_t box_size_;
+  SpeciesRegistry species_;
+  std::map<SpeciesId, Thermostat> thermostats_;
+  StaticGeometry geometry_;
+  std::vector<Particle> particles_;
+
+  /**
+   * Reads one header line.
+   * @param obstacles Receives obstacle lines, which StaticGeometry reads.
+   * @param has_species Whether a species line has replaced the defaults.
+   * @return False if the line is malformed.
+   */
+  bool ParseHeaderLine(const std::string& line, std::string* obstacles,
+                       bool* has_species);
+
+  /**
+   * Parses a CSV particle table in parallel.
+   */
+  bool ParseCsv(const char* begin, const char* end);
+
+  /**
+   * Parses a binary particle table in parallel.
+   */
+  bool ParseBinary(const char* begin, const char* end, size_t count);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace idealgas {
+
+/**
+ * The layout of a published simulation state in shared memory. The segment
+ * starts with this header and is followed by one column per field, each
+ * holding `capacity` entries:
+ *
+ *   float position_x[], float position_y[], float velocity_x[],
+ *   float velocity_y[], uint32_t type[]
+ *
+ * The header's sequence counter is odd while the publisher is writing. A
+ * reader that sees the same even value before and after reading the columns
+ * has read a consistent snapshot.
+ */
+struct SharedStateHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;
+  std::atomic<uint64_t> sequence;
+  uint64_t step;
+  uint64_t count;
+  uint64_t total_count;
+  float box_size;
+};
+
+const uint32_t kSharedStateMagic = 0x49474153;  // "IGAS"
+const uint32_t kSharedStateVersion = 1;
+
+// Columns start on cache line boundaries.
+const size_t kSharedStateAlignment = 64;
+
+enum SharedStateColumn {
+  kPositionX,
+  kPositionY,
+  kVelocityX,
+  kVelocityY,
+  kType,
+  kNumSharedStateColumns
+};
+
+/**
+ * Returns the byte offset of a column from the start of the segment.
+ */
+inline size_t GetSharedStateColumnOffset(size_t capacity,
+                                         SharedStateColumn column) {
+  size_t header_size = (sizeof(SharedStateHeader) + kSharedStateAlignment - 1) /
+                       kSharedStateAlignment * kSharedStateAlignment;
+  // Every column has 4 byte entries.
+  size_t column_size = (capacity * 4 + kSharedStateAlignment - 1) /
+                       kSharedStateAlignment * kSharedStateAlignment;
+  return header_size + column_size * column;
+}
+
+/**
+ * Returns the total size in bytes of a segment for the given capacity.
+ */
+inline size_t GetSharedStateSize(size_t capacity) {
+  return GetSharedStateColumnOffset(capacity, kNumSharedStateColumns);
+}
+
+}  // namespace idealgas
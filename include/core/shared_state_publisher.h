@@ -0,0 +1,55 @@
+#pragma once
+
+#include <core/particle.h>
+#include <core/shared_state_layout.h>
+
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * Publishes the particle state into a POSIX shared memory segment so other
+ * processes can read it. Publishing never waits on readers.
+ */
+class SharedStatePublisher {
+ public:
+  SharedStatePublisher();
+  ~SharedStatePublisher();
+  SharedStatePublisher(const SharedStatePublisher&) = delete;
+  SharedStatePublisher& operator=(const SharedStatePublisher&) = delete;
+
+  /**
+   * Creates the segment, replacing any stale segment with the same name.
+   * @param name The segment name, starting with a slash.
+   * @param capacity The most particles a snapshot can hold.
+   * @param box_size The side length of the simulation box.
+   * @return False if the segment could not be created.
+   */
+  bool Open(const std::string& name, size_t capacity, float box_size);
+
+  /**
+   * Unmaps and removes the segment.
+   */
+  void Close();
+
+  bool IsOpen() const;
+
+  /**
+   * Writes a snapshot. Particles beyond the capacity are left out, but the
+   * header still records how many there were.
+   * @param particles The particles to publish.
+   * @param step The step the particles belong to.
+   */
+  void Publish(const std::vector<Particle>& particles, size_t step);
+
+ private:
+  std::string name_;
+  void* mapping_;
+  size_t mapping_size_;
+  SharedStateHeader* header_;
+  float* columns_[kType];
+  uint32_t* types_;
+};
+
+}  // namespace idealgas
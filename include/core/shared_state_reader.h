@@ -0,0 +1,72 @@
+#pragma once
+
+#include <core/shared_state_layout.h>
+
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * Maps a segment written by SharedStatePublisher read-only. The columns can
+ * be read in place: call BeginRead(), read the columns, then check the read
+ * with EndRead(). The publisher is never blocked by readers.
+ */
+class SharedStateReader {
+ public:
+  struct Snapshot {
+    uint64_t step;
+    uint64_t total_count;
+    float box_size;
+    std::vector<float> position_x;
+    std::vector<float> position_y;
+    std::vector<float> velocity_x;
+    std::vector<float> velocity_y;
+    std::vector<uint32_t> type;
+  };
+
+  SharedStateReader();
+  ~SharedStateReader();
+  SharedStateReader(const SharedStateReader&) = delete;
+  SharedStateReader& operator=(const SharedStateReader&) = delete;
+
+  /**
+   * Maps an existing segment.
+   * @param name The segment name, starting with a slash.
+   * @return False if the segment does not exist or is not a valid state.
+   */
+  bool Open(const std::string& name);
+
+  void Close();
+
+  bool IsOpen() const;
+
+  const SharedStateHeader& GetHeader() const;
+  const float* GetColumn(SharedStateColumn column) const;
+  const uint32_t* GetTypes() const;
+
+  /**
+   * Starts a zero-copy read.
+   * @return The sequence number to pass to EndRead(). It is odd if the
+   * publisher is in the middle of a write.
+   */
+  uint64_t BeginRead() const;
+
+  /**
+   * @return True if nothing was written since BeginRead() returned sequence.
+   */
+  bool EndRead(uint64_t sequence) const;
+
+  /**
+   * Copies a consistent snapshot out of the segment.
+   * @param max_attempts How many times to retry if a write interferes.
+   * @return False if every attempt overlapped a write.
+   */
+  bool Read(Snapshot* snapshot, size_t max_attempts = 100) const;
+
+ private:
+  const void* mapping_;
+  size_t mapping_size_;
+};
+
+}  // namespace idealgas
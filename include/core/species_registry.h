@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cinder/gl/gl.h"
+
+namespace idealgas {
+
+typedef uint16_t SpeciesId;
+
+struct Species {
+  std::string name;
+  float mass;
+  float radius;
+  ci::Color color;
+};
+
+/**
+ * Describes every particle species by a compact id, and how elastic
+ * collisions between each pair of species are.
+ */
+class SpeciesRegistry {
+ public:
+  /**
+   * The three species the simulator has always offered, with ids 1 to 3.
+   */
+  static SpeciesRegistry CreateDefault();
+
+  /**
+   * Adds or replaces a species.
+   * @param id The id particles of this species carry.
+   */
+  void Register(SpeciesId id, const Species& species);
+
+  bool Contains(SpeciesId id) const;
+
+  /**
+   * Returns a registered species. The id must be registered.
+   */
+  const Species& Get(SpeciesId id) const;
+
+  /**
+   * Returns every registered id in increasing order.
+   */
+  std::vector<SpeciesId> GetIds() const;
+
+  /**
+   * Sets the coefficient of restitution for collisions between two species,
+   * in either order. 1 is perfectly elastic, 0 perfectly inelastic.
+   */
+  void SetRestitution(SpeciesId first, SpeciesId second, float restitution);
+
+  /**
+   * Returns the coefficient of restitution for two species, which is 1 unless
+   * it was set.
+   */
+  float GetRestitution(SpeciesId first, SpeciesId second) const;
+
+ private:
+  std::vector<Species> species_;
+  std::vector<bool> registered_;
+
+  // Only the pairs that were set, keyed by the smaller id first, so ids
+  // anywhere in the range cost one entry each.
+  std::map<std::pair<SpeciesId, SpeciesId>, float> restitution_;
+
+  static std::pair<SpeciesId, SpeciesId> MakePair(SpeciesId first,
+                                                  SpeciesId second);
+};
+
+}  // namespace idealgas
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * A streaming, mergeable sketch of a speed distribution. Speeds are counted
+ * in log-linear bins: below kMinSpeed everything falls into one bin, above it
+ * every power of two is split into a fixed number of equally sized sub-bins.
+ * Memory is O(bins) no matter how many particles or steps are recorded.
+ *
+ * The sketch keeps two distributions: the instantaneous one for the current
+ * step and an exponentially decayed one that carries the time average.
+ */
+class SpeedDistribution {
+ public:
+  /**
+   * @param decay The weight kept by the decayed distribution at every step.
+   * @param sub_bins_per_octave How many linear bins each power of two holds.
+   * @param num_octaves How many powers of two above kMinSpeed are covered.
+   */
+  explicit SpeedDistribution(double decay = 0.95,
+                             size_t sub_bins_per_octave = 8,
+                             size_t num_octaves = 16);
+
+  /**
+   * Records one speed in the instantaneous distribution.
+   */
+  void Add(float speed);
+
+  /**
+   * Adds a raw count to a bin of the instantaneous distribution. Bins past
+   * the last one are ignored.
+   */
+  void AddToBin(size_t bin, size_t count);
+
+  /**
+   * Adds the instantaneous counts of another sketch with the same binning.
+   * Used to combine partial sketches built by separate workers.
+   */
+  void Merge(const SpeedDistribution& other);
+
+  /**
+   * Folds the instantaneous counts into the decayed distribution. The
+   * instantaneous counts are kept so they can still be read.
+   */
+  void EndStep();
+
+  /**
+   * Clears the instantaneous distribution before a new step is recorded.
+   */
+  void ClearCounts();
+
+  /**
+   * Clears both distributions.
+   */
+  void Clear();
+
+  size_t GetNumBins() const;
+  size_t GetBinIndex(float speed) const;
+  float GetBinLowerEdge(size_t bin) const;
+  float GetBinUpperEdge(size_t bin) const;
+
+  const std::vector<size_t>& GetCounts() const;
+  const std::vector<double>& GetDecayedCounts() const;
+  size_t GetTotalCount() const;
+
+  /**
+   * Estimates how many speeds fall into [lower, upper), assuming speeds are
+   * spread evenly inside each bin.
+   * @param decayed Whether to read the decayed distribution.
+   */
+  double CountInRange(float lower, float upper, bool decayed) const;
+
+  /**
+   * Estimates the speed below which the given fraction of samples fall.
+   * @param fraction A value in [0, 1].
+   * @param decayed Whether to read the decayed distribution.
+   */
+  float Quantile(double fraction, bool decayed) const;
+
+  static constexpr float kMinSpeed = 1.0f / 64;
+
+ private:
+  double decay_;
+  size_t sub_bins_per_octave_;
+  size_t num_octaves_;
+  size_t total_count_;
+  std::vector<size_t> counts_;
+  std::vector<double> decayed_counts_;
+
+  template <typename T>
+  double CountInRange(const std::vector<T>& counts, float lower,
+                      float upper) const;
+
+  template <typename T>
+  float Quantile(const std::vector<T>& counts, double fraction) const;
+};
+
+}  // namespace idealgas
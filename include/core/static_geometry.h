@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+#include "cinder/gl/gl.h"
+
+namespace idealgas {
+
+/**
+ * A fixed obstacle particles bounce off. Every obstacle is the set of points
+ * within radius of the segment from start to end, so a line segment has a
+ * radius of 0 and a circle has the same start and end.
+ */
+struct Obstacle {
+  glm::vec2 start;
+  glm::vec2 end;
+  float radius;
+};
+
+/**
+ * The obstacles inside the box, with a bounding volume hierarchy over them so
+ * a particle only has to be tested against the obstacles near it.
+ */
+class StaticGeometry {
+ public:
+  void AddSegment(const glm::vec2& start, const glm::vec2& end);
+  void AddCircle(const glm::vec2& center, float radius);
+  void AddObstacle(const Obstacle& obstacle);
+
+  /**
+   * Adds the obstacles of a scene description, one per line:
+   *   segment <x1> <y1> <x2> <y2> [thickness]
+   *   circle <x> <y> <radius>
+   * Blank lines and lines starting with # are skipped.
+   * @param input The scene description.
+   * @return False if a line could not be read. The obstacles before it are
+   * kept.
+   */
+  bool Load(std::istream& input);
+
+  /**
+   * Rebuilds the hierarchy. Must be called after adding obstacles and before
+   * querying.
+   */
+  void Build();
+
+  void Clear();
+  bool IsEmpty() const;
+  const std::vector<Obstacle>& GetObstacles() const;
+
+  /**
+   * Appends every obstacle whose bounding box overlaps the query box.
+   * @param obstacles Receives obstacle indices.
+   */
+  void Query(const glm::vec2& min, const glm::vec2& max,
+             std::vector<size_t>* obstacles) const;
+
+  /**
+   * Returns the point of an obstacle's core segment closest to a point.
+   */
+  static glm::vec2 GetClosestPoint(const Obstacle& obstacle,
+                                   const glm::vec2& point);
+
+  /**
+   * Returns how long until a circle moving in a straight line touches an
+   * obstacle, 0 if it already overlaps it and is moving closer, or infinity
+   * if it never touches it.
+   * @param obstacle The obstacle.
+   * @param position The center of the circle.
+   * @param velocity The velocity of the circle.
+   * @param radius The radius of the circle.
+   */
+  static float GetTimeToContact(const Obstacle& obstacle,
+                                const glm::vec2& position,
+                                const glm::vec2& velocity, float radius);
+
+ private:
+  // Inner nodes have two children, stored at first and first + 1. Leaves hold
+  // count obstacles, stored at first in order_.
+  struct Node {
+    glm::vec2 min;
+    glm::vec2 max;
+    uint32_t first;
+    uint32_t count;
+  };
+
+  std::vector<Obstacle> obstacles_;
+  std::vector<glm::vec2> obstacle_min_;
+  std::vector<glm::vec2> obstacle_max_;
+  std::vector<uint32_t> order_;
+  std::vector<Node> nodes_;
+
+  /**
+   * Fills in the node covering order_[first, first + count), splitting it at
+   * the median of the longest axis until nodes are small.
+   */
+  void BuildNode(size_t node, size_t first, size_t count);
+};
+
+}  // namespace idealgas
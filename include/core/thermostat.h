@@ -0,0 +1,106 @@
+#pragma once
+
+#include <core/particle.h>
+#include <core/philox.h>
+#include <core/species_registry.h>
+
+#include <vector>
+
+namespace idealgas {
+
+enum class ThermostatKind {
+  kNone,
+  // Scales velocities so the species reaches the target in a single step.
+  kRescale,
+  // Scales velocities so the temperature relaxes towards the target with
+  // time constant coupling.
+  kBerendsen,
+  // Redraws each particle's velocity from the Maxwell-Boltzmann distribution
+  // at the target, coupling times per unit of time.
+  kAndersen
+};
+
+/**
+ * Holds one species at a target temperature, with Boltzmann's constant taken
+ * as 1, so the target is the mean kinetic energy per particle.
+ */
+struct Thermostat {
+  ThermostatKind kind;
+  float target_temperature;
+  float coupling;
+
+  /**
+   * Returns the factor that velocities are scaled by in one step.
+   * @param temperature The current temperature of the species.
+   * @param dt The time of one step.
+   */
+  float GetVelocityScale(float temperature, float dt) const;
+
+  /**
+   * Returns the chance that a particle has its velocity redrawn in one step.
+   * @param dt The time of one step.
+   */
+  float GetResampleProbability(float dt) const;
+};
+
+/**
+ * Applies every species' thermostat in a single step. The adjustment of each
+ * species is worked out once per step, so applying it costs one table lookup
+ * per particle and can be folded into any pass over the particles.
+ */
+class ThermostatPass {
+ public:
+  ThermostatPass();
+
+  /**
+   * Forgets the adjustments of the previous step.
+   */
+  void Clear();
+
+  /**
+   * Sets where this step's random draws come from. Each particle's draws are
+   * counted by its index and the step, so they do not depend on the order
+   * particles are adjusted in.
+   * @param generator The generator for thermostat draws.
+   * @param step The step number.
+   */
+  void SetRandom(const Philox& generator, uint64_t step);
+
+  /**
+   * Works out this step's adjustment for one species.
+   * @param type The species.
+   * @param thermostat The species' thermostat.
+   * @param temperature The current temperature of the species.
+   * @param dt The time of one step.
+   */
+  void AddSpecies(const SpeciesId& type, const Thermostat& thermostat,
+                  float temperature, float dt);
+
+  /**
+   * True if no particle would be changed.
+   */
+  bool IsEmpty() const;
+
+  /**
+   * Adjusts the velocity of one particle.
+   * @param particle The particle.
+   * @param index The particle's index, which keys its random draws.
+   */
+  void Apply(Particle* particle, size_t index) const;
+
+ private:
+  struct Adjustment {
+    bool active;
+    float velocity_scale;
+    float resample_probability;
+    float target_temperature;
+  };
+
+  // Indexed by species id, like the species registry.
+  std::vector<Adjustment> adjustments_;
+  bool empty_;
+  Philox random_;
+  uint64_t step_;
+};
+
+}  // namespace idealgas
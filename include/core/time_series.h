@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * A bounded-memory history of one observable. Raw samples go into the first
+ * level, and every kFactor samples of a level are summarised by min, max and
+ * mean into one sample of the next level. Each level but the last is a fixed
+ * size ring buffer of the most recent samples. The last level keeps the whole
+ * run: when it fills, adjacent pairs of its samples are merged and each of its
+ * samples covers twice as long from then on. Memory stays constant however
+ * long the simulation runs, and only the resolution of its oldest part drops.
+ */
+class TimeSeries {
+ public:
+  struct Sample {
+    double start_time;
+    double end_time;
+    float min;
+    float max;
+    float mean;
+  };
+
+  /**
+   * @param capacity How many samples each level keeps, at least 2.
+   * @param num_levels How many resolution levels to keep.
+   * @param factor How many samples of one level make a sample of the next.
+   */
+  explicit TimeSeries(size_t capacity = 1024, size_t num_levels = 4,
+                      size_t factor = 10);
+
+  /**
+   * Records a raw value.
+   * @param time The simulation time of the value.
+   * @param value The value of the observable.
+   */
+  void Add(double time, float value);
+
+  /**
+   * Returns the samples overlapping [start_time, end_time] from the finest
+   * level that still covers start_time and fits within max_points. If no level
+   * does, the coarsest level is used.
+   */
+  std::vector<Sample> Query(double start_time, double end_time,
+                            size_t max_points) const;
+
+  /**
+   * Writes the result of Query() as CSV rows of
+   * name,start_time,end_time,min,max,mean.
+   */
+  void WriteCsv(std::ostream& out, const std::string& name, double start_time,
+                double end_time, size_t max_points) const;
+
+  /**
+   * Returns every sample a level still holds, oldest first.
+   */
+  std::vector<Sample> GetLevel(size_t level) const;
+
+  size_t GetNumLevels() const;
+
+  void Clear();
+
+ private:
+  struct Level {
+    std::vector<Sample> ring;
+    size_t head;
+    size_t size;
+
+    // The aggregate of the samples of the level below not yet pushed here,
+    // with their means summed.
+    Sample pending;
+    size_t pending_count;
+
+    // How many samples of the level below, or raw values for the first
+    // level, make one sample of this one.
+    size_t width;
+  };
+
+  size_t capacity_;
+  size_t factor_;
+  std::vector<Level> levels_;
+
+  /**
+   * Folds a sample of the level below into a level's pending aggregate, and
+   * pushes the aggregate once it spans the level's width.
+   */
+  void Accumulate(size_t level, const Sample& sample);
+
+  /**
+   * Stores a sample in a level and folds it into the next level.
+   */
+  void Push(size_t level, const Sample& sample);
+
+  /**
+   * Merges adjacent pairs of the full last level and doubles its width.
+   */
+  void CompactLastLevel();
+};
+
+}  // namespace idealgas
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace idealgas {
+
+/**
+ * Moves bytes between the processes of a domain decomposed simulation. Each
+ * process has a rank in [0, GetNumRanks()). The only operation is a paired
+ * send and receive, the same shape as MPI_Sendrecv, so an MPI backend can
+ * implement it directly.
+ */
+class Transport {
+ public:
+  virtual ~Transport() = default;
+
+  virtual size_t GetRank() const = 0;
+  virtual size_t GetNumRanks() const = 0;
+
+  /**
+   * Sends a message to a peer and receives the peer's message in return. Both
+   * sides must call this with each other as the peer.
+   * @return False if the peer is gone.
+   */
+  virtual bool Exchange(size_t peer, const std::vector<char>& message,
+                        std::vector<char>* reply) = 0;
+};
+
+/**
+ * Connects processes on one machine with Unix socket pairs. Create the mesh
+ * before forking, then have every process call CreateTransport() with its
+ * own rank.
+ */
+class LocalSocketMesh {
+ public:
+  explicit LocalSocketMesh(size_t num_ranks);
+  ~LocalSocketMesh();
+  LocalSocketMesh(const LocalSocketMesh&) = delete;
+  LocalSocketMesh& operator=(const LocalSocketMesh&) = delete;
+
+  /**
+   * Returns the transport for one rank and closes every socket the rank does
+   * not use. Call it at most once per process.
+   */
+  std::unique_ptr<Transport> CreateTransport(size_t rank);
+
+ private:
+  size_t num_ranks_;
+
+  // sockets_[a][b] is the end rank a uses to talk to rank b.
+  std::vector<std::vector<int>> sockets_;
+};
+
+}  // namespace idealgas
@@ -1,5 +1,6 @@
 #pragma once
-#include <core/particle.h>
+#include <core/species_registry.h>
+#include <core/speed_distribution.h>
 
 #include "cinder/gl/gl.h"
 
@@ -9,20 +10,23 @@ namespace visualizer {
 class Histogram {
  public:
   Histogram(const glm::vec2& top_left_corner, const size_t& width_,
-            const size_t& length_, const size_t& particle_type,
-            const ci::Color& color);
+            const size_t& length_, const SpeciesId& particle_type,
+            const Species& species);
+
+  const SpeciesId& GetType() const;
 
   /**
    * Draws the box for the histogram, then calls draw labels and bars.
-   * @param particles The list of particles currently in the simulation
+   * @param distribution The speed distribution of this histogram's type
    */
-  void Draw(const std::vector<Particle>& particles) const;
+  void Draw(const SpeedDistribution& distribution) const;
 
  private:
   glm::vec2 top_left_corner_;
   size_t width_;
   size_t length_;
-  size_t particle_type_;
+  SpeciesId particle_type_;
+  std::string title_;
   ci::Color color_;
 
   const float kMargin = 20;
@@ -44,11 +48,17 @@ class Histogram {
   void DrawAxisTicks() const;
 
   /**
-   * Counts the number of particles that fall into each bin and draws the bars
-   * of the histogram.
-   * @param particles The list of particles currently in the simulation
+   * Reads how many particles fall into each bin and draws the bars of the
+   * histogram. The last bar also holds every speed past the x axis.
+   * @param distribution The speed distribution of this histogram's type
+   */
+  void DrawBars(const SpeedDistribution& distribution) const;
+
+  /**
+   * Marks the time averaged median speed with a vertical line.
+   * @param distribution The speed distribution of this histogram's type
    */
-  void DrawBars(const std::vector<Particle>& particles) const;
+  void DrawMedian(const SpeedDistribution& distribution) const;
 
   void DrawNumParticles(const size_t& num_particles) const;
 };
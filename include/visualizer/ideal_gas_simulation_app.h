@@ -7,28 +7,31 @@
 #include "particle_simulator.h"
 
 namespace idealgas {
-const float kType1Mass = 1;
-const float kType2Mass = 5;
-const float kType3Mass = 7;
-const float kRadius = 5;
 
 namespace visualizer {
-const ci::Color kType1Color = ci::Color::hex(0x0000FF); //Blue
-const ci::Color kType2Color = ci::Color::hex(0xFF0000); //Red
-const ci::Color kType3Color = ci::Color::hex(0x00FF00); //Green
 
 class IdealGasApp : public ci::app::App {
  public:
   IdealGasApp();
 
+  // Reads command line options. --publish <name> publishes every step into
+  // the named shared memory segment, --serve <endpoint> streams every step to
+  // remote viewers, --connect <endpoint> shows a remote simulation,
+  // --scenario <file> starts from the initial state in a scenario file,
+  // --obstacles <file> loads obstacles from a scene description and
+  // --seed <number> makes the run repeatable.
+  void setup() override;
+
   // Creates the window that holds a particle box.
   void draw() override;
 
   // Calls update on every object in the window.
   void update() override;
 
-  // Sets actions for enter and delete keys. Enter creates a new particle,
-  // delete clears all particles.
+  // Sets actions for enter and delete keys. Enter creates a new particle of a
+  // random species, the digit keys create a particle of that species, and
+  // delete clears all particles. The up and down arrows raise and lower the
+  // temperature the thermostats hold.
   void keyDown(ci::app::KeyEvent event) override;
 
   const size_t kMargin = 50;
@@ -37,12 +40,39 @@ class IdealGasApp : public ci::app::App {
   const size_t kParticleBoxSize = 600;
   const size_t kHistogramWidth = 100;
   const size_t kHistogramLength = 300;
+  const size_t kHistogramSpacing = 200;
+  const size_t kMaxHistograms = 3;
+  const std::string kObservablesFile = "observables.csv";
+  const size_t kMaxExportedSamples = 2000;
+  const size_t kPublishCapacity = 1 << 16;
+
+  // Split purposes 0 and 1 of a seed are the engine's.
+  const uint64_t kSpeciesDraws = 2;
+
+  // Scaling the temperature by 1.21 scales speeds by 10%.
+  const float kTemperatureStep = 1.21f;
 
  private:
   ParticleSimulator particle_sim_;
-  Histogram histogram1_;
-  Histogram histogram2_;
-  Histogram histogram3_;
+  std::vector<Histogram> histograms_;
+  // Picks the species the enter key creates.
+  PhiloxStream rng_;
+
+  /**
+   * Seeds the engine and the species picks.
+   */
+  void SetSeed(uint64_t seed);
+
+  /**
+   * Creates one histogram per species, as many as fit beside the box.
+   */
+  void CreateHistograms();
+
+  /**
+   * Writes the temperature, collision rate and particle count histories of
+   * the whole run to kObservablesFile.
+   */
+  void ExportObservables() const;
 };
 
 }  // namespace visualizer
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <core/particle.h>
+#include <core/frame_codec.h>
+#include <core/frame_server.h>
 #include <core/particle_engine.h>
+#include <core/scenario.h>
 
 #include "cinder/gl/gl.h"
 
@@ -15,7 +18,8 @@ class ParticleSimulator {
               const size_t& num_pixels_per_side);
 
   /**
-   *
+   * Steps the engine, or when connected to a server, shows the newest frame
+   * received from it instead.
    */
   void Update();
 
@@ -24,10 +28,47 @@ class ParticleSimulator {
    * @param radius The desired particle radius
    * @param mass The desired particle mass
    */
-  void GenerateRandomParticle(const float& radius, const float& mass, const size_t& type);
+  void GenerateRandomParticle(const float& radius, const float& mass, const SpeciesId& type);
+
+  /**
+   * Creates a particle of a registered species.
+   * @param type The species id.
+   */
+  void GenerateRandomParticle(const SpeciesId& type);
+
+  SpeciesRegistry& GetSpeciesRegistry();
+  const SpeciesRegistry& GetSpeciesRegistry() const;
+
+  /**
+   * Replaces the obstacles inside the box.
+   */
+  void SetStaticGeometry(const StaticGeometry& geometry);
+
+  /**
+   * Replaces everything in the box with a scenario, scaled to fit the box on
+   * screen.
+   * @param scenario The scenario, which is left without particles.
+   */
+  void ApplyScenario(Scenario* scenario);
+
+  /**
+   * Restarts the engine's random numbers from a seed.
+   */
+  void SetSeed(uint64_t seed);
 
   const ParticleEngine& GetParticleEngine() const;
 
+  /**
+   * The particles on screen, either the engine's or the remote server's.
+   */
+  const std::vector<Particle>& GetParticles() const;
+
+  /**
+   * The speed distribution of one particle type, either the engine's or the
+   * remote server's.
+   */
+  const SpeedDistribution& GetSpeedDistribution(const SpeciesId& type) const;
+
   // Draws the box and all particles.
   void Draw() const;
 
@@ -35,20 +76,53 @@ class ParticleSimulator {
   void Clear();
 
   /**
-   * Increases the velocity of every particle by 10%
+   * Publishes every following step into a shared memory segment.
+   * @param name The segment name, starting with a slash.
+   * @param capacity The most particles a published step can hold.
+   * @return False if the segment could not be created.
+   */
+  bool EnableStatePublishing(const std::string& name, size_t capacity);
+
+  /**
+   * Streams every following step to remote viewers.
+   * @param endpoint Where to listen, see FrameServer.
+   * @return False if the endpoint could not be bound.
    */
-  void AccelerateSimulation();
+  bool EnableFrameStreaming(const std::string& endpoint);
 
   /**
-   * Decreases the velocity of every particle by 10%
+   * Makes this simulator a viewer of a remote server instead of running its
+   * own engine.
+   * @param endpoint The server to connect to, see FrameServer.
+   * @return False if the connection failed.
    */
-  void DeaccelerateSimulation();
+  bool ConnectToServer(const std::string& endpoint);
+
+  /**
+   * Multiplies the target temperature of every registered species, as
+   * ParticleEngine::ScaleTargetTemperature() does.
+   * @param factor The factor to multiply by.
+   */
+  void ScaleTargetTemperature(const float& factor);
 
  private:
   glm::vec2 top_left_corner_;
   size_t num_pixels_per_side_;
   ParticleEngine particle_engine_;
   const ci::Color kParticleBoxColor = ci::Color::white();
+  const ci::Color kUnknownSpeciesColor = ci::Color::gray(0.5f);
+  const ci::Color kObstacleColor = ci::Color::black();
+
+  FrameClient frame_client_;
+  FrameDecoder frame_decoder_;
+  std::vector<Particle> remote_particles_;
+  std::map<SpeciesId, SpeedDistribution> remote_distributions_;
+  const SpeedDistribution kEmptySpeedDistribution;
+
+  /**
+   * Decodes every frame that has arrived and keeps the newest one.
+   */
+  void ReceiveFrames();
 
 };
 
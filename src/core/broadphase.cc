@@ -0,0 +1,14 @@
+#include <core/broadphase.h>
+#include <core/collision_grid.h>
+#include <core/quadtree.h>
+
+namespace idealgas {
+
+std::unique_ptr<Broadphase> Broadphase::Create(BroadphaseKind kind) {
+  if (kind == BroadphaseKind::kQuadtree) {
+    return std::unique_ptr<Broadphase>(new Quadtree());
+  }
+  return std::unique_ptr<Broadphase>(new CollisionGrid());
+}
+
+}  // namespace idealgas
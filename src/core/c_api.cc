@@ -0,0 +1,163 @@
+#include <core/c_api.h>
+#include <core/particle_engine.h>
+#include <core/scenario.h>
+
+#include <fstream>
+
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+
+// The handle is the engine itself, so views point straight into its storage.
+struct idealgas_engine {
+  idealgas_engine(size_t box_size, uint64_t seed)
+      : engine(box_size, seed), box_size(box_size) {
+  }
+
+  ParticleEngine engine;
+  size_t box_size;
+};
+
+namespace {
+
+/**
+ * Returns a view starting at one member of the first particle. Particles are
+ * stored contiguously, so each is sizeof(Particle) bytes after the last.
+ * @param first The member of the first particle, or nullptr with no
+ * particles.
+ */
+template <typename T>
+void FillView(const std::vector<Particle>& particles, const T* first,
+              const T** data, size_t* count, size_t* stride) {
+  *data = first;
+  *count = particles.size();
+  *stride = sizeof(Particle);
+}
+
+}  // namespace
+
+extern "C" {
+
+int idealgas_api_version(void) {
+  return IDEALGAS_API_VERSION;
+}
+
+idealgas_engine* idealgas_create(size_t box_size, uint64_t seed) {
+  idealgas_engine* handle = new idealgas_engine(box_size, seed);
+  handle->engine.GetSpeciesRegistry() =
+      idealgas::SpeciesRegistry::CreateDefault();
+  return handle;
+}
+
+void idealgas_destroy(idealgas_engine* engine) {
+  delete engine;
+}
+
+void idealgas_step(idealgas_engine* engine, size_t num_steps) {
+  for (size_t step = 0; step < num_steps; step++) {
+    engine->engine.Update();
+  }
+}
+
+int idealgas_spawn(idealgas_engine* engine, uint16_t type, size_t count) {
+  if (!engine->engine.GetSpeciesRegistry().Contains(type)) {
+    return 0;
+  }
+  for (size_t index = 0; index < count; index++) {
+    engine->engine.GenerateRandomParticle(type);
+  }
+  return 1;
+}
+
+int idealgas_add_particle(idealgas_engine* engine, float x, float y, float vx,
+                          float vy, float radius, float mass, uint16_t type) {
+  const idealgas::SpeciesRegistry& species =
+      engine->engine.GetSpeciesRegistry();
+  if (!species.Contains(type)) {
+    return 0;
+  }
+  engine->engine.AddParticle(Particle(
+      glm::vec2(x, y), glm::vec2(vx, vy),
+      radius > 0 ? radius : species.Get(type).radius,
+      mass > 0 ? mass : species.Get(type).mass, type));
+  return 1;
+}
+
+void idealgas_clear(idealgas_engine* engine) {
+  engine->engine.Clear();
+}
+
+int idealgas_load_scenario(idealgas_engine* engine, const char* path) {
+  idealgas::Scenario scenario;
+  if (!scenario.Load(path)) {
+    return 0;
+  }
+  scenario.ScaleTo(engine->box_size);
+  scenario.Apply(&engine->engine);
+  return 1;
+}
+
+void idealgas_set_time_step(idealgas_engine* engine, float dt) {
+  engine->engine.SetTimeStep(dt > 0 ? dt : 1);
+  engine->engine.SetContinuousCollisions(dt > 0);
+}
+
+int idealgas_set_thermostat(idealgas_engine* engine, uint16_t type, int kind,
+                            float target_temperature, float coupling) {
+  if (kind < IDEALGAS_THERMOSTAT_NONE || kind > IDEALGAS_THERMOSTAT_ANDERSEN) {
+    return 0;
+  }
+  engine->engine.SetThermostat(
+      type, idealgas::Thermostat{(idealgas::ThermostatKind)kind,
+                                 target_temperature, coupling});
+  return 1;
+}
+
+int idealgas_save_checkpoint(const idealgas_engine* engine, const char* path) {
+  std::ofstream output(path, std::ios::binary);
+  return output && engine->engine.SaveCheckpoint(output) ? 1 : 0;
+}
+
+int idealgas_load_checkpoint(idealgas_engine* engine, const char* path) {
+  std::ifstream input(path, std::ios::binary);
+  return input && engine->engine.LoadCheckpoint(input) ? 1 : 0;
+}
+
+size_t idealgas_particle_count(const idealgas_engine* engine) {
+  return engine->engine.GetParticles().size();
+}
+
+uint64_t idealgas_step_count(const idealgas_engine* engine) {
+  return engine->engine.GetStepCount();
+}
+
+float idealgas_temperature(const idealgas_engine* engine, uint16_t type) {
+  return engine->engine.GetTemperature(type);
+}
+
+idealgas_vec2_view idealgas_positions(const idealgas_engine* engine) {
+  const std::vector<Particle>& particles = engine->engine.GetParticles();
+  idealgas_vec2_view view;
+  FillView(particles,
+           particles.empty() ? nullptr : &particles[0].GetPosition().x,
+           &view.data, &view.count, &view.stride);
+  return view;
+}
+
+idealgas_vec2_view idealgas_velocities(const idealgas_engine* engine) {
+  const std::vector<Particle>& particles = engine->engine.GetParticles();
+  idealgas_vec2_view view;
+  FillView(particles,
+           particles.empty() ? nullptr : &particles[0].GetVelocity().x,
+           &view.data, &view.count, &view.stride);
+  return view;
+}
+
+idealgas_type_view idealgas_types(const idealgas_engine* engine) {
+  const std::vector<Particle>& particles = engine->engine.GetParticles();
+  idealgas_type_view view;
+  FillView(particles, particles.empty() ? nullptr : &particles[0].GetType(),
+           &view.data, &view.count, &view.stride);
+  return view;
+}
+
+}  // extern "C"
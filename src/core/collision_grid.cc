@@ -0,0 +1,106 @@
+#include <core/collision_grid.h>
+
+#include <algorithm>
+
+namespace idealgas {
+
+namespace {
+
+// Keeps the cell lists small enough to reuse when the grid is reset.
+const size_t kMaxCellsPerSide = 256;
+
+}  // namespace
+
+CollisionGrid::CollisionGrid()
+    : cell_size_(1), cells_per_side_(1), cells_(1), query_stamp_(0) {
+}
+
+void CollisionGrid::Reset(float size, float typical_size, size_t num_items) {
+  // With no typical size, as when every particle has a radius of 0, the
+  // whole area is one cell. The count is clamped before it is converted.
+  float cells = typical_size > 0 ? size / typical_size : 1;
+  cells_per_side_ =
+      cells >= 1 ? (size_t)std::min(cells, (float)kMaxCellsPerSide) : 1;
+  cell_size_ = std::max(typical_size, size / cells_per_side_);
+  if (cell_size_ <= 0) {
+    cell_size_ = 1;
+  }
+
+  cells_.resize(cells_per_side_ * cells_per_side_);
+  for (std::vector<size_t>& cell : cells_) {
+    cell.clear();
+  }
+  item_min_.resize(num_items);
+  item_max_.resize(num_items);
+  item_stamps_.assign(num_items, 0);
+  query_stamp_ = 0;
+}
+
+size_t CollisionGrid::GetCell(float coordinate) const {
+  if (coordinate <= 0) {
+    return 0;
+  }
+  return std::min(cells_per_side_ - 1, (size_t)(coordinate / cell_size_));
+}
+
+void CollisionGrid::Insert(size_t item, const glm::vec2& min,
+                           const glm::vec2& max) {
+  item_min_[item] = min;
+  item_max_[item] = max;
+  for (size_t row = GetCell(min.y); row <= GetCell(max.y); row++) {
+    for (size_t column = GetCell(min.x); column <= GetCell(max.x); column++) {
+      cells_[row * cells_per_side_ + column].push_back(item);
+    }
+  }
+}
+
+void CollisionGrid::Remove(size_t item) {
+  const glm::vec2& min = item_min_[item];
+  const glm::vec2& max = item_max_[item];
+  for (size_t row = GetCell(min.y); row <= GetCell(max.y); row++) {
+    for (size_t column = GetCell(min.x); column <= GetCell(max.x); column++) {
+      std::vector<size_t>& cell = cells_[row * cells_per_side_ + column];
+      auto it = std::find(cell.begin(), cell.end(), item);
+      if (it != cell.end()) {
+        *it = cell.back();
+        cell.pop_back();
+      }
+    }
+  }
+}
+
+void CollisionGrid::Update(size_t item, const glm::vec2& min,
+                           const glm::vec2& max) {
+  // A box that stays within the same cells only needs its bounds replaced.
+  if (GetCell(min.x) == GetCell(item_min_[item].x) &&
+      GetCell(min.y) == GetCell(item_min_[item].y) &&
+      GetCell(max.x) == GetCell(item_max_[item].x) &&
+      GetCell(max.y) == GetCell(item_max_[item].y)) {
+    item_min_[item] = min;
+    item_max_[item] = max;
+    return;
+  }
+  Remove(item);
+  Insert(item, min, max);
+}
+
+void CollisionGrid::Query(const glm::vec2& min, const glm::vec2& max,
+                          std::vector<size_t>* items) {
+  query_stamp_++;
+  for (size_t row = GetCell(min.y); row <= GetCell(max.y); row++) {
+    for (size_t column = GetCell(min.x); column <= GetCell(max.x); column++) {
+      for (size_t item : cells_[row * cells_per_side_ + column]) {
+        if (item_stamps_[item] == query_stamp_) {
+          continue;
+        }
+        item_stamps_[item] = query_stamp_;
+        if (item_min_[item].x <= max.x && min.x <= item_max_[item].x &&
+            item_min_[item].y <= max.y && min.y <= item_max_[item].y) {
+          items->push_back(item);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,398 @@
+#include <core/domain_engine.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace idealgas {
+
+namespace {
+
+// Overlaps are looked for slightly beyond contact, as finding extra ones only
+// grows the halo while missing one would change the result.
+const float kOverlapMargin = 0.01f;
+
+const uint8_t kSentFlag = 1;
+const uint8_t kTooFarFlag = 2;
+
+bool CompareIds(const std::pair<uint64_t, Particle>& first,
+                const std::pair<uint64_t, Particle>& second) {
+  return first.first < second.first;
+}
+
+template <typename T>
+void Write(std::vector<char>* bytes, T value) {
+  const char* raw = reinterpret_cast<const char*>(&value);
+  bytes->insert(bytes->end(), raw, raw + sizeof(T));
+}
+
+template <typename T>
+T Read(const std::vector<char>& bytes, size_t* offset) {
+  T value;
+  std::memcpy(&value, bytes.data() + *offset, sizeof(T));
+  *offset += sizeof(T);
+  return value;
+}
+
+}  // namespace
+
+DomainEngine::DomainEngine(const size_t& num_pixels_per_side,
+                           Transport* transport)
+    : transport_(transport),
+      slab_begin_((float)num_pixels_per_side * transport->GetRank() /
+                  transport->GetNumRanks()),
+      slab_end_((float)num_pixels_per_side * (transport->GetRank() + 1) /
+                transport->GetNumRanks()),
+      engine_(num_pixels_per_side),
+      broadphase_(Broadphase::Create(BroadphaseKind::kUniformGrid)),
+      num_indexed_(0) {
+}
+
+void DomainEngine::AddParticle(uint64_t id, const Particle& particle) {
+  size_t rank = transport_->GetRank();
+  float x = particle.GetPosition().x;
+
+  // The outer slabs also own anything past the box walls.
+  if ((rank == 0 || x >= slab_begin_) &&
+      (rank + 1 == transport_->GetNumRanks() || x < slab_end_)) {
+    std::pair<uint64_t, Particle> entry(id, particle);
+    particles_.insert(std::upper_bound(particles_.begin(), particles_.end(),
+                                       entry, CompareIds),
+                      entry);
+  }
+}
+
+bool DomainEngine::Update() {
+  size_t rank = transport_->GetRank();
+  size_t num_ranks = transport_->GetNumRanks();
+  bool has_lower = rank > 0;
+  bool has_upper = rank + 1 < num_ranks;
+
+  // With more than two slabs, a chain could only skip the slab in between if
+  // a particle reached half its width.
+  bool too_far = false;
+  local_.clear();
+  for (const auto& entry : particles_) {
+    local_.push_back(LocalParticle{entry.first, entry.second, rank, false,
+                                   false});
+    too_far = too_far || (num_ranks > 2 && 2 * GetReach(entry.second) >=
+                                               slab_end_ - slab_begin_);
+  }
+
+  // Lower ranks are always served first, which orders the exchanges along the
+  // chain of slabs so no two ranks wait on each other.
+  if ((has_lower && !ExchangeHalo(rank - 1, slab_begin_)) ||
+      (has_upper && !ExchangeHalo(rank + 1, slab_end_))) {
+    return false;
+  }
+
+  // Each round passes on the particles that joined a chain reaching another
+  // rank's particles, until no rank has any left to pass on. Particles that
+  // arrive during a round are looked at in the next, which always follows
+  // since their sender reports having sent them.
+  while (num_ranks > 1) {
+    IndexLocalParticles();
+    bool sent = false;
+    if ((has_lower && !ExchangeChains(rank - 1, &sent)) ||
+        (has_upper && !ExchangeChains(rank + 1, &sent))) {
+      return false;
+    }
+    uint8_t flags = (sent ? kSentFlag : 0) | (too_far ? kTooFarFlag : 0);
+    if (!CombineFlags(flags, &flags) || (flags & kTooFarFlag) != 0) {
+      return false;
+    }
+    if ((flags & kSentFlag) == 0) {
+      break;
+    }
+  }
+
+  // Owned and halo particles are stepped together in id order. The engine
+  // keeps that order, so owned particles can be picked out afterwards.
+  std::sort(local_.begin(), local_.end(),
+            [](const LocalParticle& first, const LocalParticle& second) {
+              return first.id < second.id;
+            });
+  engine_.Clear();
+  for (const LocalParticle& entry : local_) {
+    engine_.AddParticle(entry.particle);
+  }
+  engine_.Update();
+
+  particles_.clear();
+  const std::vector<Particle>& stepped = engine_.GetParticles();
+  for (size_t index = 0; index < local_.size(); index++) {
+    if (local_[index].source == rank) {
+      particles_.push_back(std::make_pair(local_[index].id, stepped[index]));
+    }
+  }
+
+  if ((has_lower && !ExchangeMigrants(rank - 1, true)) ||
+      (has_upper && !ExchangeMigrants(rank + 1, false))) {
+    return false;
+  }
+  std::sort(particles_.begin(), particles_.end(), CompareIds);
+  return true;
+}
+
+float DomainEngine::GetReach(const Particle& particle) {
+  return particle.GetRadius() + glm::length(particle.GetVelocity());
+}
+
+bool DomainEngine::ExchangeHalo(size_t neighbour, float edge) {
+  // Two particles on either side of the edge can only overlap after moving
+  // if they are within the sum of their reaches, so each side first learns
+  // the largest reach on the other side.
+  float max_reach = 0;
+  for (const auto& entry : particles_) {
+    max_reach = std::max(max_reach, GetReach(entry.second));
+  }
+  std::vector<char> message;
+  std::vector<char> reply;
+  Write(&message, max_reach);
+  if (!transport_->Exchange(neighbour, message, &reply) ||
+      reply.size() != sizeof(float)) {
+    return false;
+  }
+  size_t offset = 0;
+  float neighbour_reach = Read<float>(reply, &offset);
+
+  bool is_lower = neighbour < transport_->GetRank();
+  std::vector<std::pair<uint64_t, Particle>> outgoing;
+  for (LocalParticle& entry : local_) {
+    float distance = std::abs(entry.particle.GetPosition().x - edge);
+    if (entry.source == transport_->GetRank() &&
+        distance <= GetReach(entry.particle) + neighbour_reach +
+                        kOverlapMargin) {
+      outgoing.push_back(std::make_pair(entry.id, entry.particle));
+      (is_lower ? entry.sent_to_lower : entry.sent_to_upper) = true;
+    }
+  }
+
+  Serialize(outgoing, &message);
+  if (!transport_->Exchange(neighbour, message, &reply)) {
+    return false;
+  }
+  AddReceived(reply, neighbour);
+  return true;
+}
+
+bool DomainEngine::ExchangeChains(size_t neighbour, bool* sent) {
+  // A chain that reaches a particle the neighbour sent can change that
+  // particle, so the neighbour needs all of it.
+  FindChains(neighbour);
+  bool is_lower = neighbour < transport_->GetRank();
+  std::vector<std::pair<uint64_t, Particle>> outgoing;
+  for (size_t index : chain_) {
+    LocalParticle& entry = local_[index];
+    bool& known = is_lower ? entry.sent_to_lower : entry.sent_to_upper;
+    if (!known) {
+      outgoing.push_back(std::make_pair(entry.id, entry.particle));
+      known = true;
+    }
+  }
+  *sent = *sent || !outgoing.empty();
+
+  std::vector<char> message;
+  std::vector<char> reply;
+  Serialize(outgoing, &message);
+  if (!transport_->Exchange(neighbour, message, &reply)) {
+    return false;
+  }
+  AddReceived(reply, neighbour);
+  return true;
+}
+
+void DomainEngine::IndexLocalParticles() {
+  // Collisions are resolved after particles move, so overlaps are looked for
+  // between the positions the engine will move them to.
+  num_indexed_ = local_.size();
+  moved_positions_.resize(num_indexed_);
+  float max_radius = 0;
+  for (size_t index = 0; index < num_indexed_; index++) {
+    Particle moved = local_[index].particle;
+    moved.UpdatePosition(engine_.GetTimeStep());
+    moved_positions_[index] = moved.GetPosition();
+    max_radius = std::max(max_radius, moved.GetRadius());
+  }
+
+  float box_size = (slab_end_ - slab_begin_) * transport_->GetNumRanks();
+  broadphase_->Reset(box_size, 2 * max_radius + kOverlapMargin,
+                     num_indexed_);
+  for (size_t index = 0; index < num_indexed_; index++) {
+    float reach = local_[index].particle.GetRadius() + kOverlapMargin;
+    broadphase_->Insert(index, moved_positions_[index] - glm::vec2(reach),
+                        moved_positions_[index] + glm::vec2(reach));
+  }
+}
+
+void DomainEngine::FindChains(size_t neighbour) {
+  // A search outwards from the neighbour's particles, which only visits the
+  // few particles near the slab edge.
+  in_chain_.assign(num_indexed_, false);
+  chain_.clear();
+  for (size_t index = 0; index < num_indexed_; index++) {
+    if (local_[index].source == neighbour) {
+      in_chain_[index] = true;
+      chain_.push_back(index);
+    }
+  }
+
+  for (size_t next = 0; next < chain_.size(); next++) {
+    size_t index = chain_[next];
+    float radius = local_[index].particle.GetRadius();
+    float reach = radius + kOverlapMargin;
+    candidates_.clear();
+    broadphase_->Query(moved_positions_[index] - glm::vec2(reach),
+                       moved_positions_[index] + glm::vec2(reach),
+                       &candidates_);
+    for (size_t other : candidates_) {
+      float contact = radius + local_[other].particle.GetRadius();
+      if (!in_chain_[other] &&
+          glm::distance(moved_positions_[index], moved_positions_[other]) <=
+              contact + kOverlapMargin) {
+        in_chain_[other] = true;
+        chain_.push_back(other);
+      }
+    }
+  }
+}
+
+bool DomainEngine::CombineFlags(uint8_t flags, uint8_t* combined) {
+  std::vector<char> message;
+  std::vector<char> reply;
+  Write(&message, flags);
+
+  // Rank 0 collects every rank's flags, then sends the combination back.
+  if (transport_->GetRank() != 0) {
+    if (!transport_->Exchange(0, message, &reply) ||
+        !transport_->Exchange(0, message, &reply) ||
+        reply.size() != sizeof(uint8_t)) {
+      return false;
+    }
+    *combined = (uint8_t)reply[0];
+    return true;
+  }
+
+  uint8_t result = flags;
+  for (size_t rank = 1; rank < transport_->GetNumRanks(); rank++) {
+    if (!transport_->Exchange(rank, message, &reply) ||
+        reply.size() != sizeof(uint8_t)) {
+      return false;
+    }
+    result |= (uint8_t)reply[0];
+  }
+  message.clear();
+  Write(&message, result);
+  for (size_t rank = 1; rank < transport_->GetNumRanks(); rank++) {
+    if (!transport_->Exchange(rank, message, &reply)) {
+      return false;
+    }
+  }
+  *combined = result;
+  return true;
+}
+
+void DomainEngine::AddReceived(const std::vector<char>& bytes,
+                               size_t neighbour) {
+  std::vector<std::pair<uint64_t, Particle>> received;
+  Deserialize(bytes, &received);
+  bool is_lower = neighbour < transport_->GetRank();
+  for (const auto& entry : received) {
+    local_.push_back(LocalParticle{entry.first, entry.second, neighbour,
+                                   is_lower, !is_lower});
+  }
+}
+
+bool DomainEngine::ExchangeMigrants(size_t neighbour,
+                                    bool towards_lower_ranks) {
+  std::vector<std::pair<uint64_t, Particle>> staying;
+  std::vector<std::pair<uint64_t, Particle>> leaving;
+  for (const auto& entry : particles_) {
+    float x = entry.second.GetPosition().x;
+    bool leaves = towards_lower_ranks ? x < slab_begin_ : x >= slab_end_;
+    (leaves ? leaving : staying).push_back(entry);
+  }
+
+  std::vector<char> message;
+  std::vector<char> reply;
+  Serialize(leaving, &message);
+  if (!transport_->Exchange(neighbour, message, &reply)) {
+    return false;
+  }
+  particles_.swap(staying);
+  Deserialize(reply, &particles_);
+  return true;
+}
+
+bool DomainEngine::Gather(
+    std::vector<std::pair<uint64_t, Particle>>* particles) {
+  particles->clear();
+  std::vector<char> message;
+  std::vector<char> reply;
+
+  if (transport_->GetRank() != 0) {
+    Serialize(particles_, &message);
+    return transport_->Exchange(0, message, &reply);
+  }
+
+  *particles = particles_;
+  for (size_t rank = 1; rank < transport_->GetNumRanks(); rank++) {
+    if (!transport_->Exchange(rank, message, &reply)) {
+      return false;
+    }
+    Deserialize(reply, particles);
+  }
+  std::sort(particles->begin(), particles->end(), CompareIds);
+  return true;
+}
+
+const std::vector<std::pair<uint64_t, Particle>>& DomainEngine::GetParticles()
+    const {
+  return particles_;
+}
+
+float DomainEngine::GetSlabBegin() const {
+  return slab_begin_;
+}
+
+float DomainEngine::GetSlabEnd() const {
+  return slab_end_;
+}
+
+void DomainEngine::Serialize(
+    const std::vector<std::pair<uint64_t, Particle>>& from,
+    std::vector<char>* to) {
+  to->clear();
+  for (const auto& entry : from) {
+    const Particle& particle = entry.second;
+    Write(to, entry.first);
+    Write(to, particle.GetPosition().x);
+    Write(to, particle.GetPosition().y);
+    Write(to, particle.GetVelocity().x);
+    Write(to, particle.GetVelocity().y);
+    Write(to, particle.GetRadius());
+    Write(to, particle.GetMass());
+    Write(to, (uint64_t)particle.GetType());
+  }
+}
+
+void DomainEngine::Deserialize(
+    const std::vector<char>& from,
+    std::vector<std::pair<uint64_t, Particle>>* to) {
+  const size_t kRecordSize = 2 * sizeof(uint64_t) + 6 * sizeof(float);
+  size_t offset = 0;
+  while (offset + kRecordSize <= from.size()) {
+    uint64_t id = Read<uint64_t>(from, &offset);
+    float x = Read<float>(from, &offset);
+    float y = Read<float>(from, &offset);
+    float vx = Read<float>(from, &offset);
+    float vy = Read<float>(from, &offset);
+    float radius = Read<float>(from, &offset);
+    float mass = Read<float>(from, &offset);
+    SpeciesId type = (SpeciesId)Read<uint64_t>(from, &offset);
+    to->push_back(std::make_pair(
+        id, Particle(glm::vec2(x, y), glm::vec2(vx, vy), radius, mass, type)));
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,270 @@
+#include <core/frame_codec.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace idealgas {
+
+namespace {
+
+const uint32_t kFrameMagic = 0x49474652;  // "IGFR"
+const uint8_t kKeyframe = 0;
+const uint8_t kDeltaFrame = 1;
+const float kQuantizationSteps = 65535;
+// The fewest bytes a keyframe particle can take: two quantized coordinates,
+// a one byte type, the radius and the mass.
+const size_t kMinKeyframeRecordSize = 13;
+
+// Fixed size fields are stored in host byte order, which is little endian on
+// every platform the simulator targets.
+template <typename T>
+void Write(std::vector<char>* bytes, T value) {
+  const char* raw = reinterpret_cast<const char*>(&value);
+  bytes->insert(bytes->end(), raw, raw + sizeof(T));
+}
+
+void WriteVarint(std::vector<char>* bytes, uint64_t value) {
+  while (value >= 0x80) {
+    bytes->push_back((char)(value | 0x80));
+    value >>= 7;
+  }
+  bytes->push_back((char)value);
+}
+
+// Zigzag encoding maps small negative numbers to small unsigned numbers so
+// they stay short as varints.
+void WriteSignedVarint(std::vector<char>* bytes, int32_t value) {
+  WriteVarint(bytes, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+class ByteReader {
+ public:
+  explicit ByteReader(const std::vector<char>& bytes)
+      : bytes_(bytes), offset_(0), failed_(false) {
+  }
+
+  template <typename T>
+  T Read() {
+    T value = T();
+    if (offset_ + sizeof(T) > bytes_.size()) {
+      failed_ = true;
+      return value;
+    }
+    std::memcpy(&value, bytes_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return value;
+  }
+
+  uint64_t ReadVarint() {
+    uint64_t value = 0;
+    for (size_t shift = 0; shift < 64; shift += 7) {
+      if (offset_ >= bytes_.size()) {
+        break;
+      }
+      uint8_t byte = (uint8_t)bytes_[offset_++];
+      value |= (uint64_t)(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    failed_ = true;
+    return 0;
+  }
+
+  int32_t ReadSignedVarint() {
+    uint32_t value = (uint32_t)ReadVarint();
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+  }
+
+  bool Failed() const {
+    return failed_;
+  }
+
+  size_t GetRemaining() const {
+    return bytes_.size() - offset_;
+  }
+
+ private:
+  const std::vector<char>& bytes_;
+  size_t offset_;
+  bool failed_;
+};
+
+uint16_t Quantize(float coordinate, float box_size) {
+  float scaled = coordinate / box_size * kQuantizationSteps;
+  return (uint16_t)std::min(std::max(std::round(scaled), 0.0f),
+                            kQuantizationSteps);
+}
+
+float Dequantize(uint16_t quantized, float box_size) {
+  return quantized / kQuantizationSteps * box_size;
+}
+
+}  // namespace
+
+FrameEncoder::FrameEncoder(size_t keyframe_interval)
+    : keyframe_interval_(keyframe_interval),
+      frames_since_keyframe_(0),
+      keyframe_id_(0),
+      keyframe_requested_(true) {
+}
+
+void FrameEncoder::RequestKeyframe() {
+  keyframe_requested_ = true;
+}
+
+bool FrameEncoder::Encode(
+    const std::vector<Particle>& particles,
+    const std::map<SpeciesId, SpeedDistribution>& distributions, size_t step,
+    float box_size, std::vector<char>* frame) {
+  bool is_keyframe = keyframe_requested_ ||
+                     frames_since_keyframe_ >= keyframe_interval_ ||
+                     particles.size() != keyframe_x_.size();
+
+  frame->clear();
+  Write(frame, kFrameMagic);
+  if (is_keyframe) {
+    keyframe_id_++;
+    keyframe_requested_ = false;
+    frames_since_keyframe_ = 0;
+    keyframe_x_.resize(particles.size());
+    keyframe_y_.resize(particles.size());
+  }
+  frames_since_keyframe_++;
+
+  Write(frame, is_keyframe ? kKeyframe : kDeltaFrame);
+  Write(frame, keyframe_id_);
+  Write(frame, (uint64_t)step);
+  Write(frame, box_size);
+  Write(frame, (uint32_t)particles.size());
+
+  for (size_t index = 0; index < particles.size(); index++) {
+    const Particle& particle = particles[index];
+    uint16_t x = Quantize(particle.GetPosition().x, box_size);
+    uint16_t y = Quantize(particle.GetPosition().y, box_size);
+
+    if (is_keyframe) {
+      keyframe_x_[index] = x;
+      keyframe_y_[index] = y;
+      Write(frame, x);
+      Write(frame, y);
+      WriteVarint(frame, particle.GetType());
+      Write(frame, particle.GetRadius());
+      Write(frame, particle.GetMass());
+    } else {
+      WriteSignedVarint(frame, (int32_t)x - keyframe_x_[index]);
+      WriteSignedVarint(frame, (int32_t)y - keyframe_y_[index]);
+    }
+  }
+
+  WriteVarint(frame, distributions.size());
+  for (const auto& entry : distributions) {
+    const std::vector<size_t>& counts = entry.second.GetCounts();
+    WriteVarint(frame, entry.first);
+    WriteVarint(frame, counts.size());
+    for (size_t count : counts) {
+      WriteVarint(frame, count);
+    }
+  }
+  return is_keyframe;
+}
+
+FrameDecoder::FrameDecoder(size_t max_num_bins)
+    : max_num_bins_(max_num_bins),
+      has_keyframe_(false),
+      keyframe_id_(0),
+      box_size_(0) {
+}
+
+bool FrameDecoder::Decode(const std::vector<char>& bytes, Frame* frame) {
+  // Everything is decoded into locals and only kept once the whole frame has
+  // been read, so a bad frame changes neither the caller's frame nor the
+  // keyframe later deltas are read against.
+  Frame decoded;
+  ByteReader reader(bytes);
+  if (reader.Read<uint32_t>() != kFrameMagic) {
+    return false;
+  }
+  uint8_t kind = reader.Read<uint8_t>();
+  uint32_t keyframe_id = reader.Read<uint32_t>();
+  decoded.step = reader.Read<uint64_t>();
+  decoded.box_size = reader.Read<float>();
+  uint32_t count = reader.Read<uint32_t>();
+  if (reader.Failed()) {
+    return false;
+  }
+
+  decoded.is_keyframe = kind == kKeyframe;
+  std::vector<uint16_t> keyframe_x;
+  std::vector<uint16_t> keyframe_y;
+  if (decoded.is_keyframe) {
+    // The count comes off the wire, so it is checked against the bytes that
+    // are there before anything is allocated for it.
+    if (count > reader.GetRemaining() / kMinKeyframeRecordSize) {
+      return false;
+    }
+    keyframe_x.resize(count);
+    keyframe_y.resize(count);
+    decoded.particles.reserve(count);
+    for (size_t index = 0; index < count && !reader.Failed(); index++) {
+      keyframe_x[index] = reader.Read<uint16_t>();
+      keyframe_y[index] = reader.Read<uint16_t>();
+      SpeciesId type = (SpeciesId)reader.ReadVarint();
+      float radius = reader.Read<float>();
+      float mass = reader.Read<float>();
+      decoded.particles.push_back(
+          Particle(glm::vec2(Dequantize(keyframe_x[index], decoded.box_size),
+                             Dequantize(keyframe_y[index], decoded.box_size)),
+                   glm::vec2(0, 0), radius, mass, type));
+    }
+  } else if (kind == kDeltaFrame) {
+    if (!has_keyframe_ || keyframe_id != keyframe_id_ ||
+        count != keyframe_particles_.size()) {
+      return false;
+    }
+    decoded.particles = keyframe_particles_;
+    for (size_t index = 0; index < count && !reader.Failed(); index++) {
+      int32_t x = keyframe_x_[index] + reader.ReadSignedVarint();
+      int32_t y = keyframe_y_[index] + reader.ReadSignedVarint();
+      const Particle& key = keyframe_particles_[index];
+      decoded.particles[index] =
+          Particle(glm::vec2(Dequantize((uint16_t)x, box_size_),
+                             Dequantize((uint16_t)y, box_size_)),
+                   glm::vec2(0, 0), key.GetRadius(), key.GetMass(),
+                   key.GetType());
+    }
+  } else {
+    return false;
+  }
+
+  size_t num_types = (size_t)reader.ReadVarint();
+  for (size_t index = 0; index < num_types && !reader.Failed(); index++) {
+    SpeciesId type = (SpeciesId)reader.ReadVarint();
+    size_t num_bins = (size_t)reader.ReadVarint();
+    // The counts are added to sketches of max_num_bins_ bins.
+    if (num_bins > max_num_bins_) {
+      return false;
+    }
+    std::vector<size_t>& counts = decoded.histograms[type];
+    for (size_t bin = 0; bin < num_bins && !reader.Failed(); bin++) {
+      counts.push_back((size_t)reader.ReadVarint());
+    }
+  }
+  if (reader.Failed()) {
+    return false;
+  }
+
+  if (decoded.is_keyframe) {
+    has_keyframe_ = true;
+    keyframe_id_ = keyframe_id;
+    box_size_ = decoded.box_size;
+    keyframe_x_.swap(keyframe_x);
+    keyframe_y_.swap(keyframe_y);
+    keyframe_particles_ = decoded.particles;
+  }
+  std::swap(*frame, decoded);
+  return true;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,376 @@
+#include <core/frame_server.h>
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace idealgas {
+
+#ifndef _WIN32
+namespace {
+
+#ifdef MSG_NOSIGNAL
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+const char kUnixPrefix[] = "unix:";
+
+bool IsUnixEndpoint(const std::string& endpoint) {
+  return endpoint.compare(0, sizeof(kUnixPrefix) - 1, kUnixPrefix) == 0;
+}
+
+bool MakeUnixAddress(const std::string& endpoint, sockaddr_un* address) {
+  std::string path = endpoint.substr(sizeof(kUnixPrefix) - 1);
+  if (path.empty() || path.size() >= sizeof(address->sun_path)) {
+    return false;
+  }
+  std::memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  std::strncpy(address->sun_path, path.c_str(), sizeof(address->sun_path) - 1);
+  return true;
+}
+
+bool MakeTcpAddress(const std::string& endpoint, sockaddr_in* address) {
+  size_t colon = endpoint.rfind(':');
+  if (colon == std::string::npos) {
+    return false;
+  }
+  std::string host = endpoint.substr(0, colon);
+  std::string port = endpoint.substr(colon + 1);
+
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  addrinfo* result = nullptr;
+  if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints,
+                  &result) != 0) {
+    return false;
+  }
+  std::memcpy(address, result->ai_addr, sizeof(*address));
+  freeaddrinfo(result);
+  return true;
+}
+
+bool SetNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+#ifdef SO_NOSIGPIPE
+void DisableSigPipe(int fd) {
+  int enable = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+}
+#else
+void DisableSigPipe(int) {
+}
+#endif
+
+}  // namespace
+#endif
+
+FrameServer::FrameServer(size_t max_queued_frames)
+    : max_queued_frames_(max_queued_frames),
+      listen_fd_(-1),
+      port_(0),
+      dropped_frames_(0) {
+}
+
+FrameServer::~FrameServer() {
+  Close();
+}
+
+bool FrameServer::Listen(const std::string& endpoint) {
+#ifdef _WIN32
+  return false;
+#else
+  Close();
+
+  int fd;
+  if (IsUnixEndpoint(endpoint)) {
+    sockaddr_un address;
+    if (!MakeUnixAddress(endpoint, &address)) {
+      return false;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      return false;
+    }
+    // Removes a socket file left behind by an earlier server. Anything else
+    // at the path is left alone, and bind() then fails on it.
+    struct stat status;
+    if (lstat(address.sun_path, &status) == 0 && S_ISSOCK(status.st_mode)) {
+      unlink(address.sun_path);
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+        0) {
+      close(fd);
+      return false;
+    }
+    unix_path_ = address.sun_path;
+  } else {
+    sockaddr_in address;
+    if (!MakeTcpAddress(endpoint, &address)) {
+      return false;
+    }
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    if (fd < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+            0) {
+      if (fd >= 0) {
+        close(fd);
+      }
+      return false;
+    }
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+  }
+
+  if (listen(fd, SOMAXCONN) != 0 || !SetNonBlocking(fd)) {
+    close(fd);
+    return false;
+  }
+  listen_fd_ = fd;
+  return true;
+#endif
+}
+
+void FrameServer::Close() {
+#ifndef _WIN32
+  for (Client& client : clients_) {
+    close(client.fd);
+  }
+  clients_.clear();
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+  }
+  if (!unix_path_.empty()) {
+    unlink(unix_path_.c_str());
+    unix_path_.clear();
+  }
+  port_ = 0;
+#endif
+}
+
+uint16_t FrameServer::GetPort() const {
+  return port_;
+}
+
+bool FrameServer::AcceptClients() {
+#ifndef _WIN32
+  while (listen_fd_ >= 0) {
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      break;
+    }
+    if (!SetNonBlocking(fd)) {
+      close(fd);
+      continue;
+    }
+    DisableSigPipe(fd);
+    if (unix_path_.empty()) {
+      int no_delay = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    }
+
+    Client client;
+    client.fd = fd;
+    client.needs_keyframe = true;
+    client.offset = 0;
+    clients_.push_back(client);
+  }
+#endif
+
+  for (const Client& client : clients_) {
+    if (client.needs_keyframe) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t FrameServer::GetNumClients() const {
+  return clients_.size();
+}
+
+size_t FrameServer::GetDroppedFrames() const {
+  return dropped_frames_;
+}
+
+void FrameServer::Broadcast(const std::vector<char>& frame, bool is_keyframe) {
+  // Every frame is sent with its length in front of it.
+  std::vector<char> message(sizeof(uint32_t) + frame.size());
+  uint32_t length = (uint32_t)frame.size();
+  std::memcpy(message.data(), &length, sizeof(length));
+  std::memcpy(message.data() + sizeof(length), frame.data(), frame.size());
+
+  for (size_t index = 0; index < clients_.size();) {
+    Client& client = clients_[index];
+
+    if (client.queue.size() >= max_queued_frames_) {
+      // The viewer fell behind. Everything that has not started sending is
+      // dropped, and since later deltas may refer to a dropped keyframe the
+      // viewer waits for the next keyframe.
+      size_t keep = client.offset > 0 ? 1 : 0;
+      dropped_frames_ += client.queue.size() - keep;
+      client.queue.resize(keep);
+      client.needs_keyframe = true;
+    }
+
+    if (is_keyframe) {
+      client.needs_keyframe = false;
+    }
+    if (!client.needs_keyframe) {
+      client.queue.push_back(message);
+    } else {
+      dropped_frames_++;
+    }
+
+    if (Flush(&client)) {
+      index++;
+    } else {
+#ifndef _WIN32
+      close(client.fd);
+#endif
+      clients_.erase(clients_.begin() + (long)index);
+    }
+  }
+}
+
+bool FrameServer::Flush(Client* client) {
+#ifdef _WIN32
+  return false;
+#else
+  while (!client->queue.empty()) {
+    const std::vector<char>& message = client->queue.front();
+    ssize_t sent = send(client->fd, message.data() + client->offset,
+                        message.size() - client->offset, kSendFlags);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+
+    client->offset += (size_t)sent;
+    if (client->offset == message.size()) {
+      client->queue.pop_front();
+      client->offset = 0;
+    }
+  }
+  return true;
+#endif
+}
+
+FrameClient::FrameClient() : fd_(-1) {
+}
+
+FrameClient::~FrameClient() {
+  Close();
+}
+
+bool FrameClient::Connect(const std::string& endpoint) {
+#ifdef _WIN32
+  return false;
+#else
+  Close();
+
+  int fd;
+  int result;
+  if (IsUnixEndpoint(endpoint)) {
+    sockaddr_un address;
+    if (!MakeUnixAddress(endpoint, &address)) {
+      return false;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    result = fd < 0 ? -1
+                    : connect(fd, reinterpret_cast<sockaddr*>(&address),
+                              sizeof(address));
+  } else {
+    sockaddr_in address;
+    if (!MakeTcpAddress(endpoint, &address)) {
+      return false;
+    }
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    result = fd < 0 ? -1
+                    : connect(fd, reinterpret_cast<sockaddr*>(&address),
+                              sizeof(address));
+  }
+
+  if (result != 0 || !SetNonBlocking(fd)) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return false;
+  }
+  fd_ = fd;
+  buffer_.clear();
+  return true;
+#endif
+}
+
+void FrameClient::Close() {
+#ifndef _WIN32
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+#endif
+}
+
+bool FrameClient::IsConnected() const {
+  return fd_ >= 0;
+}
+
+bool FrameClient::Poll(std::vector<char>* frame) {
+#ifndef _WIN32
+  char chunk[64 * 1024];
+  while (fd_ >= 0) {
+    ssize_t received = recv(fd_, chunk, sizeof(chunk), 0);
+    if (received > 0) {
+      buffer_.insert(buffer_.end(), chunk, chunk + received);
+    } else if (received == 0) {
+      Close();
+    } else if (errno != EINTR) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        Close();
+      }
+      break;
+    }
+  }
+#endif
+
+  uint32_t length;
+  if (buffer_.size() < sizeof(length)) {
+    return false;
+  }
+  std::memcpy(&length, buffer_.data(), sizeof(length));
+  if (buffer_.size() < sizeof(length) + length) {
+    return false;
+  }
+  frame->assign(buffer_.begin() + sizeof(length),
+                buffer_.begin() + sizeof(length) + length);
+  buffer_.erase(buffer_.begin(), buffer_.begin() + sizeof(length) + length);
+  return true;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,88 @@
+#include <core/pair_potential.h>
+
+#include <cmath>
+
+namespace idealgas {
+
+template <typename Energy, typename Force>
+PairPotential::PairPotential(float min_distance, float cutoff, Energy energy,
+                             Force force_over_distance)
+    : cutoff_(cutoff),
+      min_distance_squared_(min_distance * min_distance),
+      cutoff_squared_(cutoff * cutoff),
+      entries_per_unit_((kTableSize - 1) /
+                        (cutoff_squared_ - min_distance_squared_)),
+      force_table_(kTableSize),
+      energy_table_(kTableSize) {
+  // The table is evenly spaced in squared distance, since that is what the
+  // engine has without a square root.
+  double shift = energy(cutoff);
+  for (size_t entry = 0; entry < kTableSize; entry++) {
+    double distance =
+        std::sqrt(min_distance_squared_ + entry / entries_per_unit_);
+    energy_table_[entry] = (float)(energy(distance) - shift);
+    force_table_[entry] = (float)force_over_distance(distance);
+  }
+}
+
+PairPotential PairPotential::LennardJones(float epsilon, float sigma,
+                                          float cutoff) {
+  // Nothing gets much closer than sigma / 2, where the repulsion is already
+  // 4096 times the well depth.
+  return PairPotential(
+      sigma / 2, cutoff,
+      [=](double distance) {
+        double inverse6 = std::pow(sigma / distance, 6);
+        return 4 * epsilon * (inverse6 * inverse6 - inverse6);
+      },
+      [=](double distance) {
+        double inverse6 = std::pow(sigma / distance, 6);
+        return 24 * epsilon * (2 * inverse6 * inverse6 - inverse6) /
+               (distance * distance);
+      });
+}
+
+PairPotential PairPotential::Yukawa(float strength, float screening_length,
+                                    float cutoff) {
+  return PairPotential(
+      cutoff / 100, cutoff,
+      [=](double distance) {
+        return strength * std::exp(-distance / screening_length) / distance;
+      },
+      [=](double distance) {
+        return strength * std::exp(-distance / screening_length) *
+               (1 / distance + 1 / screening_length) / (distance * distance);
+      });
+}
+
+float PairPotential::GetCutoff() const {
+  return cutoff_;
+}
+
+float PairPotential::GetForceOverDistance(float distance_squared) const {
+  return Lookup(force_table_, distance_squared);
+}
+
+float PairPotential::GetEnergy(float distance_squared) const {
+  return Lookup(energy_table_, distance_squared);
+}
+
+float PairPotential::Lookup(const std::vector<float>& table,
+                            float distance_squared) const {
+  if (distance_squared >= cutoff_squared_) {
+    return 0;
+  }
+  // Closer than the table reaches, the closest entry stands in.
+  float position = (distance_squared - min_distance_squared_) * entries_per_unit_;
+  if (position <= 0) {
+    return table[0];
+  }
+  size_t entry = (size_t)position;
+  if (entry + 1 >= kTableSize) {
+    return table[kTableSize - 1];
+  }
+  float fraction = position - entry;
+  return table[entry] + (table[entry + 1] - table[entry]) * fraction;
+}
+
+}  // namespace idealgas
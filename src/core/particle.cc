@@ -3,7 +3,7 @@
 namespace idealgas {
 
 Particle::Particle(glm::vec2 initial_pos, glm::vec2 initial_vel, float radius,
-                   float mass, size_t type)
+                   float mass, SpeciesId type)
     : position_(initial_pos), velocity_(initial_vel), radius_(radius), mass_(mass),
       type_(type) {
 }
@@ -12,6 +12,10 @@ void Particle::UpdatePosition() {
   position_ += velocity_;
 }
 
+void Particle::UpdatePosition(const float& dt) {
+  position_ += velocity_ * dt;
+}
+
 const glm::vec2& Particle::GetPosition() const{
   return position_;
 }
@@ -31,7 +35,7 @@ const float& Particle::GetMass() const {
 void Particle::SetVelocity(const glm::vec2& vel) {
   velocity_ = vel;
 }
-const size_t& Particle::GetType() const {
+const SpeciesId& Particle::GetType() const {
   return type_;
 }
 
@@ -1,23 +1,575 @@
-#include <cinder/Rand.h>
 #include <core/particle_engine.h>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
 namespace idealgas {
 
-ParticleEngine::ParticleEngine(const size_t& num_pixels_per_side)
-    : num_pixels_per_side_(num_pixels_per_side) {
-  // Sets a random seed.
-  ci::Rand::randomize();
+namespace {
+
+const float kNever = std::numeric_limits<float>::infinity();
+
+// What each generator split from the seed is for.
+const uint64_t kSpawnDraws = 0;
+const uint64_t kThermostatDraws = 1;
+
+const uint32_t kCheckpointMagic = 0x49474350;  // "IGCP"
+const uint32_t kCheckpointVersion = 1;
+
+// Fixed size fields are stored in host byte order, like frames.
+template <typename T>
+void WriteField(std::ostream& output, const T& value) {
+  output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadField(std::istream& input, T* value) {
+  return (bool)input.read(reinterpret_cast<char*>(value), sizeof(T));
+}
+
+/**
+ * Returns how long until two circles moving in straight lines touch, or
+ * kNever if they are not approaching each other.
+ * @param position The position of the first circle relative to the second.
+ * @param velocity The velocity of the first circle relative to the second.
+ * @param distance The sum of the radii.
+ */
+float TimeToContact(const glm::vec2& position, const glm::vec2& velocity,
+                    float distance) {
+  float approach = glm::dot(position, velocity);
+  if (approach >= 0) {
+    return kNever;
+  }
+  float gap = glm::dot(position, position) - distance * distance;
+  if (gap <= 0) {
+    // Already overlapping and still approaching.
+    return 0;
+  }
+  float discriminant = approach * approach - glm::dot(velocity, velocity) * gap;
+  if (discriminant < 0) {
+    return kNever;
+  }
+  // The smaller root of the quadratic, in a form that does not cancel.
+  return gap / (std::sqrt(discriminant) - approach);
+}
+
+/**
+ * Returns how long until a circle moving along one axis touches the wall it is
+ * moving towards, or kNever if it is at rest along that axis.
+ */
+float TimeToWall(float position, float velocity, float radius, float size) {
+  if (velocity < 0) {
+    return std::max(0.0f, (position - radius) / -velocity);
+  }
+  if (velocity > 0) {
+    return std::max(0.0f, (size - radius - position) / velocity);
+  }
+  return kNever;
+}
+
+}  // namespace
+
+const size_t ParticleEngine::kVerticalWall =
+    std::numeric_limits<size_t>::max();
+const size_t ParticleEngine::kHorizontalWall =
+    std::numeric_limits<size_t>::max() - 1;
+const size_t ParticleEngine::kObstacle =
+    std::numeric_limits<size_t>::max() - 2;
+const float ParticleEngine::kBroadphaseMargin = 0.01f;
+
+bool ParticleEngine::CollisionEvent::operator>(
+    const CollisionEvent& other) const {
+  return time > other.time;
+}
+
+ParticleEngine::ParticleEngine(const size_t& num_pixels_per_side,
+                               uint64_t seed)
+    : num_pixels_per_side_(num_pixels_per_side),
+      time_step_(1),
+      continuous_collisions_(false),
+      forces_valid_(false),
+      potential_energy_(0),
+      seed_(seed),
+      broadphase_(Broadphase::Create(BroadphaseKind::kUniformGrid)),
+      broadphase_kind_(BroadphaseKind::kUniformGrid),
+      broadphase_valid_(false),
+      broadphase_typical_size_(0),
+      group_by_species_(false),
+      kNoThermostat(Thermostat{ThermostatKind::kNone, 0, 0}),
+      step_count_(0),
+      step_collisions_(0) {
+  SetSeed(seed);
+}
+
+void ParticleEngine::SetSeed(uint64_t seed) {
+  seed_ = seed;
+  spawn_random_ = PhiloxStream(Philox(seed).Split(kSpawnDraws));
+  thermostat_random_ = Philox(seed).Split(kThermostatDraws);
+}
+
+const uint64_t& ParticleEngine::GetSeed() const {
+  return seed_;
+}
+
+bool ParticleEngine::SaveCheckpoint(std::ostream& output) const {
+  WriteField(output, kCheckpointMagic);
+  WriteField(output, kCheckpointVersion);
+  WriteField(output, (uint64_t)num_pixels_per_side_);
+  WriteField(output, seed_);
+  WriteField(output, spawn_random_.GetPosition());
+  WriteField(output, (uint64_t)step_count_);
+  WriteField(output, time_step_);
+  WriteField(output, (uint64_t)particles_.size());
+  for (const Particle& particle : particles_) {
+    WriteField(output, particle.GetPosition());
+    WriteField(output, particle.GetVelocity());
+    WriteField(output, particle.GetRadius());
+    WriteField(output, particle.GetMass());
+    WriteField(output, particle.GetType());
+  }
+  return (bool)output;
+}
+
+bool ParticleEngine::LoadCheckpoint(std::istream& input) {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t box_size;
+  uint64_t seed;
+  uint64_t spawn_position;
+  uint64_t step_count;
+  float time_step;
+  uint64_t num_particles;
+  if (!ReadField(input, &magic) || magic != kCheckpointMagic ||
+      !ReadField(input, &version) || version != kCheckpointVersion ||
+      !ReadField(input, &box_size) || box_size != num_pixels_per_side_ ||
+      !ReadField(input, &seed) || !ReadField(input, &spawn_position) ||
+      !ReadField(input, &step_count) || !ReadField(input, &time_step) ||
+      !ReadField(input, &num_particles)) {
+    return false;
+  }
+
+  // The particles are read in full before anything is replaced.
+  std::vector<Particle> particles;
+  for (uint64_t index = 0; index < num_particles; index++) {
+    glm::vec2 position;
+    glm::vec2 velocity;
+    float radius;
+    float mass;
+    SpeciesId type;
+    if (!ReadField(input, &position) || !ReadField(input, &velocity) ||
+        !ReadField(input, &radius) || !ReadField(input, &mass) ||
+        !ReadField(input, &type)) {
+      return false;
+    }
+    particles.push_back(Particle(position, velocity, radius, mass, type));
+  }
+
+  Clear();
+  SetSeed(seed);
+  spawn_random_.SetPosition(spawn_position);
+  time_step_ = time_step;
+  AddParticles(&particles);
+  step_count_ = (size_t)step_count;
+  return true;
 }
 
 void ParticleEngine::Update() {
-  // Moves each particle.
-  for (Particle& particle : particles_) {
-    particle.UpdatePosition();
+  step_collisions_ = 0;
+
+  PrepareThermostats();
+  if (pair_potential_) {
+    UpdateWithPairPotential();
+  } else if (continuous_collisions_) {
+    UpdateWithContinuousCollisions();
+  } else {
+    // Moves each particle, after its thermostat has adjusted its velocity.
+    bool has_thermostats = !thermostat_pass_.IsEmpty();
+    for (size_t index = 0; index < particles_.size(); index++) {
+      if (has_thermostats) {
+        thermostat_pass_.Apply(&particles_[index], index);
+      }
+      particles_[index].UpdatePosition(time_step_);
+    }
+    UpdateVelOnWallCollision();
+    if (!geometry_.IsEmpty()) {
+      UpdateVelOnObstacleCollision();
+    }
+    if (particles_.size() > 1) {
+      UpdateVelOnParticleCollision();
+    }
+  }
+  step_count_++;
+  RecordObservables();
+  if (state_publisher_) {
+    state_publisher_->Publish(particles_, step_count_);
+  }
+  if (frame_server_) {
+    StreamFrame();
+  }
+}
+
+void ParticleEngine::PrepareThermostats() {
+  thermostat_pass_.Clear();
+  thermostat_pass_.SetRandom(thermostat_random_, step_count_);
+  for (const auto& entry : thermostats_) {
+    thermostat_pass_.AddSpecies(entry.first, entry.second,
+                                GetTemperature(entry.first), time_step_);
+  }
+}
+
+void ParticleEngine::UpdateWithPairPotential() {
+  if (!forces_valid_) {
+    ComputeForces();
+  }
+
+  // Half a kick with the old forces, then a drift, in the same pass as the
+  // thermostats.
+  float half_step = time_step_ / 2;
+  bool has_thermostats = !thermostat_pass_.IsEmpty();
+  for (size_t index = 0; index < particles_.size(); index++) {
+    Particle& particle = particles_[index];
+    if (has_thermostats) {
+      thermostat_pass_.Apply(&particle, index);
+    }
+    particle.SetVelocity(particle.GetVelocity() +
+                         accelerations_[index] * half_step);
+    particle.UpdatePosition(time_step_);
   }
   UpdateVelOnWallCollision();
-  if (particles_.size() > 1) {
-    UpdateVelOnParticleCollision();
+  if (!geometry_.IsEmpty()) {
+    UpdateVelOnObstacleCollision();
+  }
+
+  // The other half kick with the new forces.
+  ComputeForces();
+  for (size_t index = 0; index < particles_.size(); index++) {
+    Particle& particle = particles_[index];
+    particle.SetVelocity(particle.GetVelocity() +
+                         accelerations_[index] * half_step);
+  }
+}
+
+void ParticleEngine::ComputeForces() {
+  size_t num_particles = particles_.size();
+  accelerations_.assign(num_particles, glm::vec2(0, 0));
+  potential_energy_ = 0;
+  forces_valid_ = true;
+  if (num_particles == 0) {
+    return;
+  }
+
+  // Particles go in as points. With grid cells as wide as the cutoff, each
+  // particle's neighbours lie in the cells around its own.
+  float cutoff = pair_potential_->GetCutoff();
+  float cutoff_squared = cutoff * cutoff;
+  box_min_.resize(num_particles);
+  box_max_.resize(num_particles);
+  for (size_t index = 0; index < num_particles; index++) {
+    box_min_[index] = particles_[index].GetPosition();
+    box_max_[index] = particles_[index].GetPosition();
+  }
+  RefreshBroadphase(cutoff);
+
+  glm::vec2 reach(cutoff, cutoff);
+  for (size_t index1 = 0; index1 < num_particles; index1++) {
+    const Particle& particle1 = particles_[index1];
+    candidates_.clear();
+    broadphase_->Query(particle1.GetPosition() - reach,
+                       particle1.GetPosition() + reach, &candidates_);
+    // Forces are summed in index order, so they do not depend on how the
+    // broadphase stores particles, and a resumed run sums them the same way.
+    std::sort(candidates_.begin(), candidates_.end());
+    for (size_t index2 : candidates_) {
+      if (index2 <= index1) {
+        continue;
+      }
+      const Particle& particle2 = particles_[index2];
+      glm::vec2 offset = particle1.GetPosition() - particle2.GetPosition();
+      float distance_squared = glm::dot(offset, offset);
+      if (distance_squared >= cutoff_squared) {
+        continue;
+      }
+      glm::vec2 force =
+          pair_potential_->GetForceOverDistance(distance_squared) * offset;
+      accelerations_[index1] += force / particle1.GetMass();
+      accelerations_[index2] -= force / particle2.GetMass();
+      potential_energy_ += pair_potential_->GetEnergy(distance_squared);
+    }
+  }
+}
+
+void ParticleEngine::UpdateWithContinuousCollisions() {
+  size_t num_particles = particles_.size();
+  particle_times_.assign(num_particles, 0);
+  collision_counts_.assign(num_particles, 0);
+  events_.clear();
+  PredictInitialCollisions();
+
+  std::greater<CollisionEvent> later;
+  size_t max_events = kMaxEventsPerParticle * num_particles;
+  size_t num_events = 0;
+  while (!events_.empty() && num_events < max_events) {
+    std::pop_heap(events_.begin(), events_.end(), later);
+    CollisionEvent event = events_.back();
+    events_.pop_back();
+
+    bool is_fixed = event.particle2 == kVerticalWall ||
+                    event.particle2 == kHorizontalWall ||
+                    event.particle2 == kObstacle;
+    if (collision_counts_[event.particle1] != event.count1 ||
+        (!is_fixed && collision_counts_[event.particle2] != event.count2)) {
+      continue;
+    }
+    num_events++;
+
+    AdvanceParticle(event.particle1, event.time);
+    Particle& particle1 = particles_[event.particle1];
+    collision_counts_[event.particle1]++;
+    if (event.particle2 == kVerticalWall) {
+      particle1.SetVelocity(
+          glm::vec2(-particle1.GetVelocity().x, particle1.GetVelocity().y));
+    } else if (event.particle2 == kHorizontalWall) {
+      particle1.SetVelocity(
+          glm::vec2(particle1.GetVelocity().x, -particle1.GetVelocity().y));
+    } else if (event.particle2 == kObstacle) {
+      ReflectOffObstacle(particle1, geometry_.GetObstacles()[event.obstacle]);
+    } else {
+      AdvanceParticle(event.particle2, event.time);
+      Particle& particle2 = particles_[event.particle2];
+      collision_counts_[event.particle2]++;
+      glm::vec2 new_vel1 = CalculateParticleCollisionVel(particle1, particle2);
+      glm::vec2 new_vel2 = CalculateParticleCollisionVel(particle2, particle1);
+      particle1.SetVelocity(new_vel1);
+      particle2.SetVelocity(new_vel2);
+      step_collisions_++;
+      PredictCollisions(event.particle2, event.time);
+    }
+    PredictCollisions(event.particle1, event.time);
+  }
+
+  for (size_t index = 0; index < num_particles; index++) {
+    AdvanceParticle(index, time_step_);
+  }
+}
+
+void ParticleEngine::PredictInitialCollisions() {
+  size_t num_particles = particles_.size();
+  if (num_particles == 0) {
+    return;
+  }
+
+  // Grid cells are sized to the typical path, so most paths touch few cells.
+  // The thermostats are applied first, since they change the paths.
+  bool has_thermostats = !thermostat_pass_.IsEmpty();
+  float max_radius = 0;
+  float path_lengths = 0;
+  for (size_t index = 0; index < num_particles; index++) {
+    Particle& particle = particles_[index];
+    if (has_thermostats) {
+      thermostat_pass_.Apply(&particle, index);
+    }
+    max_radius = std::max(max_radius, particle.GetRadius());
+    glm::vec2 velocity = particle.GetVelocity();
+    path_lengths +=
+        std::max(std::abs(velocity.x), std::abs(velocity.y)) * time_step_;
+  }
+  box_min_.resize(num_particles);
+  box_max_.resize(num_particles);
+  for (size_t index = 0; index < num_particles; index++) {
+    GetSweptBox(index, &box_min_[index], &box_max_[index]);
+  }
+  RefreshBroadphase(std::max(2 * max_radius, path_lengths / num_particles));
+
+  for (size_t index = 0; index < num_particles; index++) {
+    PredictWallCollision(index, 0);
+    PredictObstacleCollision(index, 0);
+    candidates_.clear();
+    broadphase_->Query(box_min_[index], box_max_[index], &candidates_);
+    std::sort(candidates_.begin(), candidates_.end());
+    for (size_t other : candidates_) {
+      if (other > index) {
+        PredictParticleCollision(index, other, 0);
+      }
+    }
+  }
+}
+
+void ParticleEngine::PredictCollisions(size_t index, float time) {
+  glm::vec2 min;
+  glm::vec2 max;
+  GetSweptBox(index, &min, &max);
+  broadphase_->Update(index, min, max);
+
+  PredictWallCollision(index, time);
+  PredictObstacleCollision(index, time);
+  candidates_.clear();
+  broadphase_->Query(min, max, &candidates_);
+  std::sort(candidates_.begin(), candidates_.end());
+  for (size_t other : candidates_) {
+    if (other != index) {
+      PredictParticleCollision(index, other, time);
+    }
+  }
+}
+
+void ParticleEngine::GetSweptBox(size_t index, glm::vec2* min,
+                                 glm::vec2* max) const {
+  const Particle& particle = particles_[index];
+  glm::vec2 start = particle.GetPosition();
+  glm::vec2 end = start + particle.GetVelocity() *
+                              (time_step_ - particle_times_[index]);
+  glm::vec2 radius(particle.GetRadius(), particle.GetRadius());
+  *min = glm::min(start, end) - radius;
+  *max = glm::max(start, end) + radius;
+}
+
+void ParticleEngine::PredictWallCollision(size_t index, float time) {
+  const Particle& particle = particles_[index];
+  glm::vec2 position = particle.GetPosition() +
+                       particle.GetVelocity() * (time - particle_times_[index]);
+  float size = (float)num_pixels_per_side_;
+  float x_time = TimeToWall(position.x, particle.GetVelocity().x,
+                            particle.GetRadius(), size);
+  float y_time = TimeToWall(position.y, particle.GetVelocity().y,
+                            particle.GetRadius(), size);
+
+  CollisionEvent event;
+  event.time = time + std::min(x_time, y_time);
+  event.particle1 = index;
+  event.particle2 = x_time <= y_time ? kVerticalWall : kHorizontalWall;
+  event.count1 = collision_counts_[index];
+  event.count2 = 0;
+  event.obstacle = 0;
+  if (event.time <= time_step_) {
+    events_.push_back(event);
+    std::push_heap(events_.begin(), events_.end(),
+                   std::greater<CollisionEvent>());
+  }
+}
+
+void ParticleEngine::PredictObstacleCollision(size_t index, float time) {
+  if (geometry_.IsEmpty()) {
+    return;
+  }
+  glm::vec2 min;
+  glm::vec2 max;
+  GetSweptBox(index, &min, &max);
+  nearby_obstacles_.clear();
+  geometry_.Query(min, max, &nearby_obstacles_);
+
+  // Only the first contact is queued. Any later one is predicted again after
+  // the particle bounces.
+  const Particle& particle = particles_[index];
+  glm::vec2 position = particle.GetPosition() +
+                       particle.GetVelocity() * (time - particle_times_[index]);
+  CollisionEvent event;
+  event.time = kNever;
+  for (size_t obstacle : nearby_obstacles_) {
+    float contact_time = time + StaticGeometry::GetTimeToContact(
+                                    geometry_.GetObstacles()[obstacle],
+                                    position, particle.GetVelocity(),
+                                    particle.GetRadius());
+    if (contact_time < event.time) {
+      event.time = contact_time;
+      event.obstacle = obstacle;
+    }
+  }
+  event.particle1 = index;
+  event.particle2 = kObstacle;
+  event.count1 = collision_counts_[index];
+  event.count2 = 0;
+  if (event.time <= time_step_) {
+    events_.push_back(event);
+    std::push_heap(events_.begin(), events_.end(),
+                   std::greater<CollisionEvent>());
+  }
+}
+
+void ParticleEngine::PredictParticleCollision(size_t index1, size_t index2,
+                                              float time) {
+  const Particle& particle1 = particles_[index1];
+  const Particle& particle2 = particles_[index2];
+  glm::vec2 position1 =
+      particle1.GetPosition() +
+      particle1.GetVelocity() * (time - particle_times_[index1]);
+  glm::vec2 position2 =
+      particle2.GetPosition() +
+      particle2.GetVelocity() * (time - particle_times_[index2]);
+
+  CollisionEvent event;
+  event.time = time + TimeToContact(
+                          position1 - position2,
+                          particle1.GetVelocity() - particle2.GetVelocity(),
+                          particle1.GetRadius() + particle2.GetRadius());
+  event.particle1 = index1;
+  event.particle2 = index2;
+  event.count1 = collision_counts_[index1];
+  event.count2 = collision_counts_[index2];
+  event.obstacle = 0;
+  if (event.time <= time_step_) {
+    events_.push_back(event);
+    std::push_heap(events_.begin(), events_.end(),
+                   std::greater<CollisionEvent>());
+  }
+}
+
+void ParticleEngine::AdvanceParticle(size_t index, float time) {
+  particles_[index].UpdatePosition(time - particle_times_[index]);
+  particle_times_[index] = time;
+}
+
+void ParticleEngine::StreamFrame() {
+  if (frame_server_->AcceptClients()) {
+    frame_encoder_.RequestKeyframe();
+  }
+  if (frame_server_->GetNumClients() == 0) {
+    return;
   }
+  bool is_keyframe =
+      frame_encoder_.Encode(particles_, speed_distributions_, step_count_,
+                            (float)num_pixels_per_side_, &frame_);
+  frame_server_->Broadcast(frame_, is_keyframe);
+}
+
+void ParticleEngine::RecordObservables() {
+  for (auto& entry : speed_distributions_) {
+    entry.second.ClearCounts();
+  }
+
+  // The distribution and energy are only looked up when the species changes,
+  // so grouped particles cost one lookup per species.
+  species_energies_.clear();
+  double kinetic_energy = 0;
+  SpeedDistribution* distribution = nullptr;
+  SpeciesEnergy* energy = nullptr;
+  SpeciesId distribution_type = 0;
+  for (const Particle& particle : particles_) {
+    if (distribution == nullptr || particle.GetType() != distribution_type) {
+      distribution_type = particle.GetType();
+      distribution = &speed_distributions_[distribution_type];
+      energy = &species_energies_[distribution_type];
+    }
+    float speed_squared =
+        glm::dot(particle.GetVelocity(), particle.GetVelocity());
+    double particle_energy = 0.5 * particle.GetMass() * speed_squared;
+    kinetic_energy += particle_energy;
+    energy->kinetic_energy += particle_energy;
+    energy->num_particles++;
+    distribution->Add(std::sqrt(speed_squared));
+  }
+
+  for (auto& entry : speed_distributions_) {
+    entry.second.EndStep();
+  }
+
+  // In two dimensions the mean kinetic energy per particle equals kT.
+  float temperature =
+      particles_.empty() ? 0 : (float)(kinetic_energy / particles_.size());
+  temperature_history_.Add((double)step_count_, temperature);
+  collision_rate_history_.Add((double)step_count_, (float)step_collisions_);
+  particle_count_history_.Add((double)step_count_, (float)particles_.size());
 }
 
 void ParticleEngine::UpdateVelOnWallCollision() {
@@ -45,37 +597,248 @@ void ParticleEngine::UpdateVelOnWallCollision() {
   }
 }
 
-void ParticleEngine::GenerateRandomParticle(const float& radius, const float& mass, const size_t& type) {
-  // RandFloat(a,b) generates a random float in [a,b).
+void ParticleEngine::UpdateVelOnObstacleCollision() {
+  for (Particle& particle : particles_) {
+    glm::vec2 radius(particle.GetRadius(), particle.GetRadius());
+    nearby_obstacles_.clear();
+    geometry_.Query(particle.GetPosition() - radius,
+                    particle.GetPosition() + radius, &nearby_obstacles_);
+    for (size_t obstacle_index : nearby_obstacles_) {
+      const Obstacle& obstacle = geometry_.GetObstacles()[obstacle_index];
+      if (glm::distance(particle.GetPosition(),
+                        StaticGeometry::GetClosestPoint(
+                            obstacle, particle.GetPosition())) <=
+          particle.GetRadius() + obstacle.radius) {
+        ReflectOffObstacle(particle, obstacle);
+      }
+    }
+  }
+}
+
+void ParticleEngine::ReflectOffObstacle(Particle& particle,
+                                        const Obstacle& obstacle) const {
+  // The surface normal at the contact points from the obstacle's core
+  // segment to the particle's center.
+  glm::vec2 offset =
+      particle.GetPosition() -
+      StaticGeometry::GetClosestPoint(obstacle, particle.GetPosition());
+  float distance = glm::length(offset);
+  if (distance == 0) {
+    return;
+  }
+  glm::vec2 normal = offset / distance;
+  float approach = glm::dot(particle.GetVelocity(), normal);
+  if (approach < 0) {
+    particle.SetVelocity(particle.GetVelocity() - 2 * approach * normal);
+  }
+}
+
+void ParticleEngine::GenerateRandomParticle(const float& radius, const float& mass, const SpeciesId& type) {
+  // NextFloat(a,b) generates a random float in [a,b).
   glm::vec2 pos_vec =
-      glm::vec2(ci::randFloat(1, (float)num_pixels_per_side_ - 1),
-                ci::randFloat(1, (float)num_pixels_per_side_ - 1));
+      glm::vec2(spawn_random_.NextFloat(1, (float)num_pixels_per_side_ - 1),
+                spawn_random_.NextFloat(1, (float)num_pixels_per_side_ - 1));
 
-  // RandPosNegFloat(a,b) generates a random float in [a,b) and [-a,-b).
-  glm::vec2 vel_vec = glm::vec2(ci::randPosNegFloat(0, radius),
-                                ci::randPosNegFloat(0, radius));
+  // Each velocity component is in (-radius, radius).
+  glm::vec2 vel_vec = glm::vec2(spawn_random_.NextFloat(-radius, radius),
+                                spawn_random_.NextFloat(-radius, radius));
 
-  particles_.push_back(Particle(pos_vec, vel_vec, radius, mass, type));
+  AddParticle(Particle(pos_vec, vel_vec, radius, mass, type));
 }
 
-void ParticleEngine::UpdateVelOnParticleCollision() {
-  for (size_t index = 0; index < particles_.size() - 1; index++) {
-    Particle& particle1 = particles_[index];
-    for (size_t index2 = index + 1; index2 < particles_.size(); index2++) {
-      Particle& particle2 = particles_[index2];
+void ParticleEngine::GenerateRandomParticle(const SpeciesId& type) {
+  const Species& species = species_.Get(type);
+  GenerateRandomParticle(species.radius, species.mass, type);
+}
+
+void ParticleEngine::SetTimeStep(const float& dt) {
+  time_step_ = dt;
+}
+
+const float& ParticleEngine::GetTimeStep() const {
+  return time_step_;
+}
 
-      if (WillParticlesCollide(particle1, particle2)) {
-        glm::vec2 new_vel1 =
-            CalculateParticleCollisionVel(particle1, particle2);
+void ParticleEngine::SetContinuousCollisions(bool continuous_collisions) {
+  continuous_collisions_ = continuous_collisions;
+}
 
-        glm::vec2 new_vel2 =
-            CalculateParticleCollisionVel(particle2, particle1);
+void ParticleEngine::SetBroadphase(BroadphaseKind kind) {
+  broadphase_ = Broadphase::Create(kind);
+  broadphase_kind_ = kind;
+  broadphase_valid_ = false;
+}
+
+BroadphaseKind ParticleEngine::GetBroadphase() const {
+  return broadphase_kind_;
+}
 
-        particle1.SetVelocity(new_vel1);
-        particle2.SetVelocity(new_vel2);
+void ParticleEngine::SetPairPotential(const PairPotential& potential) {
+  pair_potential_.reset(new PairPotential(potential));
+  forces_valid_ = false;
+}
+
+void ParticleEngine::ClearPairPotential() {
+  pair_potential_.reset();
+  potential_energy_ = 0;
+}
+
+double ParticleEngine::GetPotentialEnergy() const {
+  return potential_energy_;
+}
+
+void ParticleEngine::SetStaticGeometry(const StaticGeometry& geometry) {
+  geometry_ = geometry;
+  geometry_.Build();
+}
+
+const StaticGeometry& ParticleEngine::GetStaticGeometry() const {
+  return geometry_;
+}
+
+void ParticleEngine::SetThermostat(const SpeciesId& type,
+                                   const Thermostat& thermostat) {
+  if (thermostat.kind == ThermostatKind::kNone) {
+    thermostats_.erase(type);
+  } else {
+    thermostats_[type] = thermostat;
+  }
+}
+
+void ParticleEngine::ClearThermostats() {
+  thermostats_.clear();
+}
+
+const Thermostat& ParticleEngine::GetThermostat(const SpeciesId& type) const {
+  auto it = thermostats_.find(type);
+  if (it == thermostats_.end()) {
+    return kNoThermostat;
+  }
+  return it->second;
+}
+
+void ParticleEngine::ScaleTargetTemperature(const float& factor) {
+  for (SpeciesId type : species_.GetIds()) {
+    Thermostat thermostat = GetThermostat(type);
+    if (thermostat.kind == ThermostatKind::kNone) {
+      float temperature = GetTemperature(type);
+      if (temperature <= 0) {
+        continue;
       }
+      thermostat = Thermostat{ThermostatKind::kRescale, temperature, 0};
+    }
+    thermostat.target_temperature *= factor;
+    SetThermostat(type, thermostat);
+  }
+}
+
+float ParticleEngine::GetTemperature(const SpeciesId& type) const {
+  auto it = species_energies_.find(type);
+  if (it == species_energies_.end() || it->second.num_particles == 0) {
+    return 0;
+  }
+  return (float)(it->second.kinetic_energy / it->second.num_particles);
+}
+
+SpeciesRegistry& ParticleEngine::GetSpeciesRegistry() {
+  return species_;
+}
+
+const SpeciesRegistry& ParticleEngine::GetSpeciesRegistry() const {
+  return species_;
+}
 
+namespace {
+
+bool CompareSpecies(const Particle& particle1, const Particle& particle2) {
+  return particle1.GetType() < particle2.GetType();
+}
+
+}  // namespace
+
+void ParticleEngine::SetGroupBySpecies(bool group_by_species) {
+  group_by_species_ = group_by_species;
+  if (group_by_species_) {
+    forces_valid_ = false;
+    broadphase_valid_ = false;
+    std::stable_sort(particles_.begin(), particles_.end(), CompareSpecies);
+  }
+}
+
+std::pair<size_t, size_t> ParticleEngine::GetSpeciesRange(
+    const SpeciesId& type) const {
+  Particle key(glm::vec2(0, 0), glm::vec2(0, 0), 0, 0, type);
+  auto range =
+      std::equal_range(particles_.begin(), particles_.end(), key, CompareSpecies);
+  return std::make_pair((size_t)(range.first - particles_.begin()),
+                        (size_t)(range.second - particles_.begin()));
+}
+
+void ParticleEngine::UpdateVelOnParticleCollision() {
+  // Only overlapping particles can collide, and positions do not change in
+  // this pass, so the broadphase finds every pair that can. The pairs are then
+  // resolved in the order of a loop over all pairs, which keeps the result
+  // identical to testing every pair.
+  size_t num_particles = particles_.size();
+  box_min_.resize(num_particles);
+  box_max_.resize(num_particles);
+  float max_radius = 0;
+  for (size_t index = 0; index < num_particles; index++) {
+    const Particle& particle = particles_[index];
+    float reach = particle.GetRadius() + kBroadphaseMargin;
+    box_min_[index] = particle.GetPosition() - glm::vec2(reach, reach);
+    box_max_[index] = particle.GetPosition() + glm::vec2(reach, reach);
+    max_radius = std::max(max_radius, particle.GetRadius());
+  }
+  RefreshBroadphase(2 * max_radius + kBroadphaseMargin);
+
+  candidate_pairs_.clear();
+  for (size_t index = 0; index < num_particles; index++) {
+    candidates_.clear();
+    broadphase_->Query(box_min_[index], box_max_[index], &candidates_);
+    for (size_t other : candidates_) {
+      if (other > index) {
+        candidate_pairs_.push_back(std::make_pair(index, other));
+      }
+    }
+  }
+  std::sort(candidate_pairs_.begin(), candidate_pairs_.end());
+
+  for (const std::pair<size_t, size_t>& pair : candidate_pairs_) {
+    Particle& particle1 = particles_[pair.first];
+    Particle& particle2 = particles_[pair.second];
+
+    if (WillParticlesCollide(particle1, particle2)) {
+      glm::vec2 new_vel1 =
+          CalculateParticleCollisionVel(particle1, particle2);
+
+      glm::vec2 new_vel2 =
+          CalculateParticleCollisionVel(particle2, particle1);
+
+      particle1.SetVelocity(new_vel1);
+      particle2.SetVelocity(new_vel2);
+      step_collisions_++;
+    }
+  }
+}
+
+void ParticleEngine::RefreshBroadphase(float typical_size) {
+  // Grid cells are sized when the broadphase is rebuilt, so it is rebuilt
+  // when the typical box has changed a lot.
+  size_t num_particles = particles_.size();
+  if (!broadphase_valid_ || typical_size > 2 * broadphase_typical_size_ ||
+      typical_size < broadphase_typical_size_ / 2) {
+    broadphase_->Reset((float)num_pixels_per_side_, typical_size,
+                       num_particles);
+    for (size_t index = 0; index < num_particles; index++) {
+      broadphase_->Insert(index, box_min_[index], box_max_[index]);
     }
+    broadphase_typical_size_ = typical_size;
+    broadphase_valid_ = true;
+    return;
+  }
+  for (size_t index = 0; index < num_particles; index++) {
+    broadphase_->Update(index, box_min_[index], box_max_[index]);
   }
 }
 
@@ -89,7 +852,11 @@ bool ParticleEngine::WillParticlesCollide(const Particle& particle1,
 
 glm::vec2 ParticleEngine::CalculateParticleCollisionVel(
     const Particle& particle1, const Particle& particle2) const {
-  return particle1.GetVelocity() - (2 * particle2.GetMass()) / (particle1.GetMass() + particle2.GetMass()) *
+  // A perfectly elastic collision has a restitution of 1, giving the usual
+  // factor of 2.
+  float restitution =
+      species_.GetRestitution(particle1.GetType(), particle2.GetType());
+  return particle1.GetVelocity() - ((1 + restitution) * particle2.GetMass()) / (particle1.GetMass() + particle2.GetMass()) *
          (glm::dot((particle1.GetVelocity() - particle2.GetVelocity()),
                    (particle1.GetPosition() - particle2.GetPosition()))) /
              (glm::pow(
@@ -99,51 +866,125 @@ glm::vec2 ParticleEngine::CalculateParticleCollisionVel(
 }
 
 void ParticleEngine::AddParticle(const Particle& particle) {
-  particles_.push_back(particle);
+  SpeciesEnergy& energy = species_energies_[particle.GetType()];
+  float speed_squared =
+      glm::dot(particle.GetVelocity(), particle.GetVelocity());
+  energy.kinetic_energy += 0.5 * particle.GetMass() * speed_squared;
+  energy.num_particles++;
+  forces_valid_ = false;
+  broadphase_valid_ = false;
+
+  if (group_by_species_) {
+    particles_.insert(std::upper_bound(particles_.begin(), particles_.end(),
+                                       particle, CompareSpecies),
+                      particle);
+  } else {
+    particles_.push_back(particle);
+  }
+}
+
+void ParticleEngine::AddParticles(std::vector<Particle>* particles) {
+  // Particles usually come in runs of one species, so the energy of the last
+  // species is looked up again only when the species changes.
+  SpeciesEnergy* energy = nullptr;
+  SpeciesId type = 0;
+  for (const Particle& particle : *particles) {
+    if (energy == nullptr || particle.GetType() != type) {
+      type = particle.GetType();
+      energy = &species_energies_[type];
+    }
+    float speed_squared =
+        glm::dot(particle.GetVelocity(), particle.GetVelocity());
+    energy->kinetic_energy += 0.5 * particle.GetMass() * speed_squared;
+    energy->num_particles++;
+  }
+  forces_valid_ = false;
+  broadphase_valid_ = false;
+
+  if (particles_.empty()) {
+    particles_.swap(*particles);
+  } else {
+    particles_.insert(particles_.end(), particles->begin(), particles->end());
+  }
+  particles->clear();
+  if (group_by_species_) {
+    std::stable_sort(particles_.begin(), particles_.end(), CompareSpecies);
+  }
 }
 
 const std::vector<Particle>& ParticleEngine::GetParticles() const {
   return particles_;
 }
 
-void ParticleEngine::Clear() {
-  particles_.clear();
+const SpeedDistribution& ParticleEngine::GetSpeedDistribution(
+    const SpeciesId& type) const {
+  auto it = speed_distributions_.find(type);
+  if (it == speed_distributions_.end()) {
+    return kEmptySpeedDistribution;
+  }
+  return it->second;
 }
 
-void ParticleEngine::AccelerateParticles() {
-  for (Particle& particle : particles_) {
+size_t ParticleEngine::GetStepCount() const {
+  return step_count_;
+}
 
-    if (particle.GetVelocity().x < 0) {
-      particle.SetVelocity(particle.GetVelocity() + glm::vec2(0.1 * particle.GetVelocity().x, 0));
-    } else if (particle.GetVelocity().x > 0) {
-      particle.SetVelocity(particle.GetVelocity() + glm::vec2(0.1 * particle.GetVelocity().x, 0));
-    }
+const TimeSeries& ParticleEngine::GetTemperatureHistory() const {
+  return temperature_history_;
+}
 
-    if (particle.GetVelocity().y < 0) {
-      particle.SetVelocity(particle.GetVelocity() + glm::vec2(0, 0.1 * particle.GetVelocity().y));
-    } else if (particle.GetVelocity().y > 0) {
-      particle.SetVelocity(particle.GetVelocity() + glm::vec2(0, 0.1 * particle.GetVelocity().y));
-    }
+const TimeSeries& ParticleEngine::GetCollisionRateHistory() const {
+  return collision_rate_history_;
+}
 
+const TimeSeries& ParticleEngine::GetParticleCountHistory() const {
+  return particle_count_history_;
+}
+
+bool ParticleEngine::EnableStatePublishing(const std::string& name,
+                                           size_t capacity) {
+  std::unique_ptr<SharedStatePublisher> publisher(new SharedStatePublisher());
+  if (!publisher->Open(name, capacity, (float)num_pixels_per_side_)) {
+    return false;
   }
+  publisher->Publish(particles_, step_count_);
+  state_publisher_ = std::move(publisher);
+  return true;
 }
 
-void ParticleEngine::DeaccelerateParticles() {
-  for (Particle& particle : particles_) {
+void ParticleEngine::DisableStatePublishing() {
+  state_publisher_.reset();
+}
 
-    if (particle.GetVelocity().x < 0) {
-      particle.SetVelocity(particle.GetVelocity() - glm::vec2(0.1 * particle.GetVelocity().x, 0));
-    } else if (particle.GetVelocity().x > 0) {
-      particle.SetVelocity(particle.GetVelocity() - glm::vec2(0.1 * particle.GetVelocity().x, 0));
-    }
+bool ParticleEngine::EnableFrameStreaming(const std::string& endpoint) {
+  std::unique_ptr<FrameServer> server(new FrameServer());
+  if (!server->Listen(endpoint)) {
+    return false;
+  }
+  frame_server_ = std::move(server);
+  frame_encoder_.RequestKeyframe();
+  return true;
+}
 
-    if (particle.GetVelocity().y < 0) {
-      particle.SetVelocity(particle.GetVelocity() - glm::vec2(0, 0.1 * particle.GetVelocity().y));
-    } else if (particle.GetVelocity().y > 0) {
-      particle.SetVelocity(particle.GetVelocity() - glm::vec2(0, 0.1 * particle.GetVelocity().y));
-    }
+void ParticleEngine::DisableFrameStreaming() {
+  frame_server_.reset();
+}
 
-  }
+const FrameServer* ParticleEngine::GetFrameServer() const {
+  return frame_server_.get();
+}
+
+void ParticleEngine::Clear() {
+  particles_.clear();
+  speed_distributions_.clear();
+  species_energies_.clear();
+  forces_valid_ = false;
+  broadphase_valid_ = false;
+  potential_energy_ = 0;
+  step_count_ = 0;
+  temperature_history_.Clear();
+  collision_rate_history_.Clear();
+  particle_count_history_.Clear();
 }
 
 }  // namespace idealgas
@@ -0,0 +1,92 @@
+#include <core/philox.h>
+
+#include <cmath>
+
+namespace idealgas {
+
+namespace {
+
+const uint32_t kMultiplier0 = 0xD2511F53;
+const uint32_t kMultiplier1 = 0xCD9E8D57;
+const uint32_t kWeyl0 = 0x9E3779B9;
+const uint32_t kWeyl1 = 0xBB67AE85;
+const size_t kNumRounds = 10;
+
+// 2^-24, the gap between floats just below 1.
+const float kFloatUnit = 1.0f / 16777216.0f;
+const float kTwoPi = 6.28318530717958647692f;
+
+}  // namespace
+
+Philox::Philox(uint64_t key) : key_(key) {
+}
+
+const uint64_t& Philox::GetKey() const {
+  return key_;
+}
+
+Philox::Block Philox::Generate(uint64_t first, uint64_t second) const {
+  Block counter = {{(uint32_t)first, (uint32_t)(first >> 32),
+                    (uint32_t)second, (uint32_t)(second >> 32)}};
+  uint32_t key0 = (uint32_t)key_;
+  uint32_t key1 = (uint32_t)(key_ >> 32);
+  for (size_t round = 0; round < kNumRounds; round++) {
+    uint64_t product0 = (uint64_t)kMultiplier0 * counter[0];
+    uint64_t product1 = (uint64_t)kMultiplier1 * counter[2];
+    counter = {{(uint32_t)(product1 >> 32) ^ counter[1] ^ key0,
+                (uint32_t)product1,
+                (uint32_t)(product0 >> 32) ^ counter[3] ^ key1,
+                (uint32_t)product0}};
+    key0 += kWeyl0;
+    key1 += kWeyl1;
+  }
+  return counter;
+}
+
+Philox Philox::Split(uint64_t purpose) const {
+  // Keys come from a counter no other draw uses, the top of the range.
+  Block words = Generate(purpose, UINT64_MAX);
+  return Philox(((uint64_t)words[1] << 32) | words[0]);
+}
+
+float Philox::ToFloat(uint32_t bits) {
+  return (float)(bits >> 8) * kFloatUnit;
+}
+
+glm::vec2 Philox::ToGaussians(uint32_t first, uint32_t second) {
+  // Box-Muller, with the first number in (0, 1] so its log is finite.
+  float radius = std::sqrt(-2 * std::log((float)((first >> 8) + 1) *
+                                         kFloatUnit));
+  float angle = kTwoPi * ToFloat(second);
+  return glm::vec2(radius * std::cos(angle), radius * std::sin(angle));
+}
+
+PhiloxStream::PhiloxStream(const Philox& generator)
+    : generator_(generator), position_(0), block_() {
+}
+
+uint32_t PhiloxStream::NextBits() {
+  size_t word = position_ % 4;
+  if (word == 0) {
+    block_ = generator_.Generate(position_ / 4, 0);
+  }
+  position_++;
+  return block_[word];
+}
+
+float PhiloxStream::NextFloat(float min, float max) {
+  return min + (max - min) * Philox::ToFloat(NextBits());
+}
+
+const uint64_t& PhiloxStream::GetPosition() const {
+  return position_;
+}
+
+void PhiloxStream::SetPosition(uint64_t position) {
+  position_ = position;
+  if (position_ % 4 != 0) {
+    block_ = generator_.Generate(position_ / 4, 0);
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,269 @@
+#include <core/quadtree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace idealgas {
+
+namespace {
+
+// A leaf splits when it holds more items than this, and a subtree collapses
+// into one node when it holds at most half as many, so items near the
+// threshold do not make nodes split and merge every step.
+const size_t kMaxLeafItems = 8;
+const size_t kMaxDepth = 16;
+
+glm::vec2 GetCenter(const glm::vec2& min, const glm::vec2& max) {
+  return (min + max) * 0.5f;
+}
+
+float GetExtent(const glm::vec2& min, const glm::vec2& max) {
+  return std::max(max.x - min.x, max.y - min.y) * 0.5f;
+}
+
+}  // namespace
+
+const uint32_t Quadtree::kNone = std::numeric_limits<uint32_t>::max();
+
+Quadtree::Quadtree() : num_nodes_(0) {
+  Reset(1, 1, 0);
+}
+
+void Quadtree::Reset(float size, float, size_t num_items) {
+  nodes_.resize(1);
+  Node& root = nodes_[0];
+  root.center = glm::vec2(size / 2, size / 2);
+  root.half_size = size / 2;
+  root.parent = kNone;
+  root.children = kNone;
+  root.depth = 0;
+  root.subtree_count = 0;
+  root.entries.clear();
+  free_groups_.clear();
+  num_nodes_ = 1;
+
+  item_node_.assign(num_items, kNone);
+  item_slot_.resize(num_items);
+}
+
+bool Quadtree::Fits(uint32_t node, const glm::vec2& center,
+                    float extent) const {
+  // The root also holds everything outside the box.
+  if (node == 0) {
+    return true;
+  }
+  const Node& square = nodes_[node];
+  glm::vec2 offset = center - square.center;
+  return std::abs(offset.x) <= square.half_size &&
+         std::abs(offset.y) <= square.half_size &&
+         extent <= square.half_size / 2;
+}
+
+uint32_t Quadtree::GetChild(uint32_t node, const glm::vec2& point) const {
+  const Node& square = nodes_[node];
+  return square.children + (point.x >= square.center.x ? 1 : 0) +
+         (point.y >= square.center.y ? 2 : 0);
+}
+
+void Quadtree::Insert(size_t item, const glm::vec2& min, const glm::vec2& max) {
+  glm::vec2 center = GetCenter(min, max);
+  float extent = GetExtent(min, max);
+
+  uint32_t node = 0;
+  while (nodes_[node].children != kNone) {
+    uint32_t child = GetChild(node, center);
+    if (!Fits(child, center, extent)) {
+      break;
+    }
+    node = child;
+  }
+  AddToNode(node, Entry{min, max, item});
+
+  if (nodes_[node].children == kNone &&
+      nodes_[node].entries.size() > kMaxLeafItems &&
+      nodes_[node].depth < kMaxDepth) {
+    Split(node);
+  }
+}
+
+void Quadtree::AddToNode(uint32_t node, const Entry& entry) {
+  item_node_[entry.item] = node;
+  item_slot_[entry.item] = (uint32_t)nodes_[node].entries.size();
+  nodes_[node].entries.push_back(entry);
+  for (uint32_t ancestor = node; ancestor != kNone;
+       ancestor = nodes_[ancestor].parent) {
+    nodes_[ancestor].subtree_count++;
+  }
+}
+
+void Quadtree::Split(uint32_t node) {
+  uint32_t children;
+  if (free_groups_.empty()) {
+    children = (uint32_t)nodes_.size();
+    nodes_.resize(nodes_.size() + 4);
+  } else {
+    children = free_groups_.back();
+    free_groups_.pop_back();
+  }
+  num_nodes_ += 4;
+
+  float quarter = nodes_[node].half_size / 2;
+  for (uint32_t index = 0; index < 4; index++) {
+    Node& child = nodes_[children + index];
+    child.center = nodes_[node].center +
+                   glm::vec2(index & 1 ? quarter : -quarter,
+                             index & 2 ? quarter : -quarter);
+    child.half_size = quarter;
+    child.parent = node;
+    child.children = kNone;
+    child.depth = nodes_[node].depth + 1;
+    child.subtree_count = 0;
+    child.entries.clear();
+  }
+  nodes_[node].children = children;
+
+  // Items move down without changing the count of this node's subtree.
+  std::vector<Entry> entries;
+  entries.swap(nodes_[node].entries);
+  for (const Entry& entry : entries) {
+    glm::vec2 center = GetCenter(entry.min, entry.max);
+    uint32_t child = GetChild(node, center);
+    uint32_t target =
+        Fits(child, center, GetExtent(entry.min, entry.max)) ? child : node;
+    item_node_[entry.item] = target;
+    item_slot_[entry.item] = (uint32_t)nodes_[target].entries.size();
+    nodes_[target].entries.push_back(entry);
+    if (target != node) {
+      nodes_[target].subtree_count++;
+    }
+  }
+
+  for (uint32_t child = children; child < children + 4; child++) {
+    if (nodes_[child].entries.size() > kMaxLeafItems &&
+        nodes_[child].depth < kMaxDepth) {
+      Split(child);
+    }
+  }
+}
+
+void Quadtree::Remove(size_t item) {
+  uint32_t node = item_node_[item];
+  std::vector<Entry>& entries = nodes_[node].entries;
+  entries[item_slot_[item]] = entries.back();
+  item_slot_[entries.back().item] = item_slot_[item];
+  entries.pop_back();
+  item_node_[item] = kNone;
+
+  // Collapses the highest ancestor whose subtree has become small.
+  uint32_t collapse = kNone;
+  for (uint32_t ancestor = node; ancestor != kNone;
+       ancestor = nodes_[ancestor].parent) {
+    nodes_[ancestor].subtree_count--;
+    if (nodes_[ancestor].children != kNone &&
+        nodes_[ancestor].subtree_count <= kMaxLeafItems / 2) {
+      collapse = ancestor;
+    }
+  }
+  if (collapse != kNone) {
+    Collapse(collapse);
+  }
+}
+
+void Quadtree::Collapse(uint32_t node) {
+  uint32_t children = nodes_[node].children;
+  for (uint32_t child = children; child < children + 4; child++) {
+    if (nodes_[child].children != kNone) {
+      Collapse(child);
+    }
+    for (const Entry& entry : nodes_[child].entries) {
+      item_node_[entry.item] = node;
+      item_slot_[entry.item] = (uint32_t)nodes_[node].entries.size();
+      nodes_[node].entries.push_back(entry);
+    }
+    nodes_[child].entries.clear();
+  }
+  nodes_[node].children = kNone;
+  free_groups_.push_back(children);
+  num_nodes_ -= 4;
+}
+
+void Quadtree::Update(size_t item, const glm::vec2& min, const glm::vec2& max) {
+  // An item that still belongs in its node, and could not go further down,
+  // stays where it is.
+  uint32_t node = item_node_[item];
+  glm::vec2 center = GetCenter(min, max);
+  float extent = GetExtent(min, max);
+  if (Fits(node, center, extent) &&
+      (nodes_[node].children == kNone ||
+       !Fits(GetChild(node, center), center, extent))) {
+    Entry& entry = nodes_[node].entries[item_slot_[item]];
+    entry.min = min;
+    entry.max = max;
+    return;
+  }
+  Remove(item);
+  Insert(item, min, max);
+}
+
+void Quadtree::Query(const glm::vec2& min, const glm::vec2& max,
+                     std::vector<size_t>* items) {
+  pending_.clear();
+  pending_.push_back(0);
+  while (!pending_.empty()) {
+    const Node& node = nodes_[pending_.back()];
+    pending_.pop_back();
+
+    for (const Entry& entry : node.entries) {
+      if (entry.min.x <= max.x && min.x <= entry.max.x &&
+          entry.min.y <= max.y && min.y <= entry.max.y) {
+        items->push_back(entry.item);
+      }
+    }
+    if (node.children == kNone) {
+      continue;
+    }
+
+    // Items reach up to half a node size past their node's square, so the
+    // low children reach from 2.5 to -0.5 quarters below the center and the
+    // high children from -0.5 to 2.5 quarters above it.
+    float quarter = node.half_size / 2;
+    glm::vec2 low = node.center - 2.5f * quarter;
+    glm::vec2 high = node.center + 2.5f * quarter;
+    bool left = min.x <= node.center.x + quarter / 2 && max.x >= low.x;
+    bool right = max.x >= node.center.x - quarter / 2 && min.x <= high.x;
+    bool bottom = min.y <= node.center.y + quarter / 2 && max.y >= low.y;
+    bool top = max.y >= node.center.y - quarter / 2 && min.y <= high.y;
+    bool overlaps[4] = {left && bottom, right && bottom, left && top,
+                        right && top};
+    for (uint32_t index = 0; index < 4; index++) {
+      if (overlaps[index] &&
+          nodes_[node.children + index].subtree_count != 0) {
+        pending_.push_back(node.children + index);
+      }
+    }
+  }
+}
+
+size_t Quadtree::GetNumNodes() const {
+  return num_nodes_;
+}
+
+size_t Quadtree::GetDepth() const {
+  size_t depth = 0;
+  std::vector<uint32_t> pending(1, 0);
+  while (!pending.empty()) {
+    const Node& node = nodes_[pending.back()];
+    pending.pop_back();
+    depth = std::max(depth, (size_t)node.depth);
+    if (node.children != kNone) {
+      for (uint32_t child = node.children; child < node.children + 4;
+           child++) {
+        pending.push_back(child);
+      }
+    }
+  }
+  return depth;
+}
+
+}  // namespace idealgas
@@ -0,0 +1,583 @@
+#include <core/scenario.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace idealgas {
+
+namespace {
+
+// Chunks smaller than this are not worth a thread of their own.
+const size_t kMinChunkBytes = 1 << 20;
+const size_t kBinaryRecordSize = 7 * 4;
+const size_t kMaxSpeciesId = 0xffff;
+
+/**
+ * A read only view of a whole file. It is mapped where the platform allows,
+ * so the particle table is paged in by the threads that parse it.
+ */
+class MappedFile {
+ public:
+  MappedFile() : data_(nullptr), size_(0) {
+  }
+
+  ~MappedFile() {
+#ifndef _WIN32
+    if (data_ != nullptr && buffer_.empty()) {
+      munmap((void*)data_, size_);
+    }
+#endif
+  }
+
+  bool Open(const std::string& path) {
+#ifdef _WIN32
+    std::ifstream input(path, std::ios::binary);
+    buffer_.assign(std::istreambuf_iterator<char>(input),
+                   std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return input.good() || input.eof();
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+      close(fd);
+      return false;
+    }
+    size_ = (size_t)status.st_size;
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+      size_ = 0;
+      return false;
+    }
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+    data_ = (const char*)mapping;
+    return true;
+#endif
+  }
+
+  const char* GetData() const {
+    return data_;
+  }
+
+  size_t GetSize() const {
+    return size_;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+  std::vector<char> buffer_;
+};
+
+bool IsBlank(char character) {
+  return character == ' ' || character == '\t' || character == '\r';
+}
+
+const char* SkipBlanks(const char* cursor, const char* end) {
+  while (cursor < end && IsBlank(*cursor)) {
+    cursor++;
+  }
+  return cursor;
+}
+
+/**
+ * Returns the end of the line starting at begin, which is its newline or the
+ * end of the text.
+ */
+const char* FindLineEnd(const char* begin, const char* end) {
+  const char* newline = (const char*)std::memchr(begin, '\n', end - begin);
+  return newline == nullptr ? end : newline;
+}
+
+/**
+ * True if a line holds a record rather than nothing or a comment.
+ */
+bool IsRecord(const char* begin, const char* end) {
+  begin = SkipBlanks(begin, end);
+  return begin < end && *begin != '#';
+}
+
+/**
+ * Parses an unsigned decimal integer and moves the cursor past it.
+ */
+bool ParseUnsigned(const char** cursor, const char* end, uint64_t* value) {
+  const char* start = *cursor;
+  uint64_t result = 0;
+  while (*cursor < end && **cursor >= '0' && **cursor <= '9' &&
+         *cursor - start < 19) {
+    result = result * 10 + (uint64_t)(**cursor - '0');
+    (*cursor)++;
+  }
+  *value = result;
+  return *cursor > start;
+}
+
+/**
+ * Parses a decimal number with an optional sign, fraction and exponent and
+ * moves the cursor past it. This avoids strtof, which needs the text to be
+ * null terminated and consults the locale for every number.
+ */
+bool ParseFloat(const char** cursor, const char* end, float* value) {
+  static const double kPowersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                        1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                        1e18, 1e19, 1e20, 1e21, 1e22};
+  const char* position = *cursor;
+  bool negative = position < end && *position == '-';
+  if (position < end && (*position == '-' || *position == '+')) {
+    position++;
+  }
+
+  // Digits past the 19th only change the exponent.
+  uint64_t mantissa = 0;
+  int exponent = 0;
+  size_t num_digits = 0;
+  while (position < end && *position >= '0' && *position <= '9') {
+    if (num_digits < 19) {
+      mantissa = mantissa * 10 + (uint64_t)(*position - '0');
+    } else {
+      exponent++;
+    }
+    num_digits++;
+    position++;
+  }
+  if (position < end && *position == '.') {
+    position++;
+    while (position < end && *position >= '0' && *position <= '9') {
+      if (num_digits < 19) {
+        mantissa = mantissa * 10 + (uint64_t)(*position - '0');
+        exponent--;
+      }
+      num_digits++;
+      position++;
+    }
+  }
+  if (num_digits == 0) {
+    return false;
+  }
+  if (position < end && (*position == 'e' || *position == 'E')) {
+    position++;
+    bool negative_exponent = position < end && *position == '-';
+    if (position < end && (*position == '-' || *position == '+')) {
+      position++;
+    }
+    uint64_t magnitude;
+    if (!ParseUnsigned(&position, end, &magnitude)) {
+      return false;
+    }
+    magnitude = std::min(magnitude, (uint64_t)1000);
+    exponent += negative_exponent ? -(int)magnitude : (int)magnitude;
+  }
+
+  double result = (double)mantissa;
+  if (exponent < 0) {
+    result /= -exponent <= 22 ? kPowersOfTen[-exponent]
+                              : std::pow(10.0, -exponent);
+  } else if (exponent > 0) {
+    result *= exponent <= 22 ? kPowersOfTen[exponent]
+                             : std::pow(10.0, exponent);
+  }
+  *value = (float)(negative ? -result : result);
+  *cursor = position;
+  return true;
+}
+
+/**
+ * Moves the cursor past a comma and the blanks around it.
+ */
+bool ParseComma(const char** cursor, const char* end) {
+  *cursor = SkipBlanks(*cursor, end);
+  if (*cursor == end || **cursor != ',') {
+    return false;
+  }
+  *cursor = SkipBlanks(*cursor + 1, end);
+  return true;
+}
+
+/**
+ * Builds a particle, taking a radius or mass of 0 from its species.
+ * @return False if the particle needs its species and it is not registered.
+ */
+bool MakeParticle(const SpeciesRegistry& species, const glm::vec2& position,
+                  const glm::vec2& velocity, float radius, float mass,
+                  uint64_t type, Particle* particle) {
+  if (type > kMaxSpeciesId) {
+    return false;
+  }
+  if (radius == 0 || mass == 0) {
+    if (!species.Contains((SpeciesId)type)) {
+      return false;
+    }
+    const Species& defaults = species.Get((SpeciesId)type);
+    radius = radius == 0 ? defaults.radius : radius;
+    mass = mass == 0 ? defaults.mass : mass;
+  }
+  *particle = Particle(position, velocity, radius, mass, (SpeciesId)type);
+  return true;
+}
+
+/**
+ * Parses one "x,y,vx,vy,type[,radius,mass]" line.
+ */
+bool ParseCsvRecord(const char* cursor, const char* end,
+                    const SpeciesRegistry& species, Particle* particle) {
+  glm::vec2 position;
+  glm::vec2 velocity;
+  uint64_t type;
+  cursor = SkipBlanks(cursor, end);
+  if (!ParseFloat(&cursor, end, &position.x) || !ParseComma(&cursor, end) ||
+      !ParseFloat(&cursor, end, &position.y) || !ParseComma(&cursor, end) ||
+      !ParseFloat(&cursor, end, &velocity.x) || !ParseComma(&cursor, end) ||
+      !ParseFloat(&cursor, end, &velocity.y) || !ParseComma(&cursor, end) ||
+      !ParseUnsigned(&cursor, end, &type)) {
+    return false;
+  }
+
+  float radius = 0;
+  float mass = 0;
+  cursor = SkipBlanks(cursor, end);
+  if (cursor < end &&
+      (!ParseComma(&cursor, end) || !ParseFloat(&cursor, end, &radius) ||
+       !ParseComma(&cursor, end) || !ParseFloat(&cursor, end, &mass))) {
+    return false;
+  }
+  if (SkipBlanks(cursor, end) != end) {
+    return false;
+  }
+  return MakeParticle(species, position, velocity, radius, mass, type,
+                      particle);
+}
+
+size_t CountCsvRecords(const char* begin, const char* end) {
+  size_t count = 0;
+  while (begin < end) {
+    const char* line_end = FindLineEnd(begin, end);
+    if (IsRecord(begin, line_end)) {
+      count++;
+    }
+    begin = line_end + 1;
+  }
+  return count;
+}
+
+/**
+ * Parses the lines in [begin, end) into consecutive particles.
+ * @return False at the first malformed line.
+ */
+bool ParseCsvChunk(const char* begin, const char* end,
+                   const SpeciesRegistry& species, Particle* particles) {
+  while (begin < end) {
+    const char* line_end = FindLineEnd(begin, end);
+    if (IsRecord(begin, line_end)) {
+      if (!ParseCsvRecord(begin, line_end, species, particles)) {
+        return false;
+      }
+      particles++;
+    }
+    begin = line_end + 1;
+  }
+  return true;
+}
+
+bool ParseBinaryChunk(const char* begin, size_t count,
+                      const SpeciesRegistry& species, Particle* particles) {
+  for (size_t index = 0; index < count; index++) {
+    float fields[6];
+    uint32_t type;
+    std::memcpy(fields, begin, sizeof(fields));
+    std::memcpy(&type, begin + sizeof(fields), sizeof(type));
+    begin += kBinaryRecordSize;
+    if (!MakeParticle(species, glm::vec2(fields[0], fields[1]),
+                      glm::vec2(fields[2], fields[3]), fields[4], fields[5],
+                      type, &particles[index])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Returns how many threads to split a table of this many bytes between.
+ */
+size_t GetNumChunks(size_t num_bytes) {
+  size_t num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  return std::max(std::min(num_threads, num_bytes / kMinChunkBytes),
+                  (size_t)1);
+}
+
+/**
+ * Runs task(0) to task(num_chunks - 1), each on its own thread but the last.
+ */
+template <typename Task>
+void RunChunks(size_t num_chunks, const Task& task) {
+  std::vector<std::thread> threads;
+  for (size_t chunk = 0; chunk + 1 < num_chunks; chunk++) {
+    threads.push_back(std::thread(task, chunk));
+  }
+  task(num_chunks - 1);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+const Particle kEmptyParticle(glm::vec2(0, 0), glm::vec2(0, 0), 0, 0, 0);
+
+}  // namespace
+
+Scenario::Scenario()
+    : box_size_(0), species_(SpeciesRegistry::CreateDefault()) {
+}
+
+bool Scenario::Load(const std::string& path) {
+  box_size_ = 0;
+  species_ = SpeciesRegistry::CreateDefault();
+  thermostats_.clear();
+  geometry_ = StaticGeometry();
+  particles_.clear();
+
+  MappedFile file;
+  if (!file.Open(path)) {
+    return false;
+  }
+  const char* cursor = file.GetData();
+  const char* end = cursor + file.GetSize();
+
+  // The header is short, so it is read line by line like the obstacle files.
+  std::string obstacles;
+  bool has_species = false;
+  while (cursor < end) {
+    const char* line_end = FindLineEnd(cursor, end);
+    std::string line(cursor, line_end);
+    cursor = std::min(line_end + 1, end);
+
+    std::istringstream fields(line);
+    std::string kind;
+    std::string format;
+    if (!(fields >> kind) || kind != "particles") {
+      if (!ParseHeaderLine(line, &obstacles, &has_species)) {
+        return false;
+      }
+      continue;
+    }
+
+    std::istringstream obstacle_lines(obstacles);
+    if (box_size_ == 0 || !geometry_.Load(obstacle_lines) ||
+        !(fields >> format)) {
+      return false;
+    }
+    if (format == "csv") {
+      return ParseCsv(cursor, end);
+    }
+    size_t count;
+    if (format == "binary" && fields >> count) {
+      return ParseBinary(cursor, end, count);
+    }
+    return false;
+  }
+  return false;
+}
+
+bool Scenario::ParseHeaderLine(const std::string& line, std::string* obstacles,
+                               bool* has_species) {
+  std::istringstream fields(line);
+  std::string kind;
+  if (!(fields >> kind) || kind[0] == '#') {
+    return true;
+  }
+
+  if (kind == "box") {
+    fields >> box_size_;
+  } else if (kind == "species") {
+    size_t id;
+    Species species;
+    fields >> id >> species.name >> species.mass >> species.radius >>
+        species.color.r >> species.color.g >> species.color.b;
+    if (fields.fail() || id > kMaxSpeciesId) {
+      return false;
+    }
+    // The first species replaces the defaults.
+    if (!*has_species) {
+      species_ = SpeciesRegistry();
+      *has_species = true;
+    }
+    species_.Register((SpeciesId)id, species);
+  } else if (kind == "restitution") {
+    size_t first;
+    size_t second;
+    float restitution;
+    fields >> first >> second >> restitution;
+    if (fields.fail() || first > kMaxSpeciesId || second > kMaxSpeciesId ||
+        !species_.Contains((SpeciesId)first) ||
+        !species_.Contains((SpeciesId)second)) {
+      return false;
+    }
+    species_.SetRestitution((SpeciesId)first, (SpeciesId)second, restitution);
+  } else if (kind == "thermostat") {
+    size_t id;
+    std::string name;
+    Thermostat thermostat{ThermostatKind::kNone, 0, 0};
+    fields >> id >> name >> thermostat.target_temperature;
+    if (fields.fail() || id > kMaxSpeciesId) {
+      return false;
+    }
+    if (name == "rescale") {
+      thermostat.kind = ThermostatKind::kRescale;
+    } else if (name == "berendsen") {
+      thermostat.kind = ThermostatKind::kBerendsen;
+    } else if (name == "andersen") {
+      thermostat.kind = ThermostatKind::kAndersen;
+    } else {
+      return false;
+    }
+    fields >> thermostat.coupling;
+    thermostats_[(SpeciesId)id] = thermostat;
+    return true;
+  } else if (kind == "segment" || kind == "circle") {
+    *obstacles += line;
+    *obstacles += '\n';
+    return true;
+  } else {
+    return false;
+  }
+  return !fields.fail();
+}
+
+bool Scenario::ParseCsv(const char* begin, const char* end) {
+  // Chunks are cut at line starts, counted in parallel, and then parsed in
+  // parallel straight into their own range of particles.
+  size_t num_chunks = GetNumChunks(end - begin);
+  std::vector<const char*> bounds(num_chunks + 1, end);
+  bounds[0] = begin;
+  for (size_t chunk = 1; chunk < num_chunks; chunk++) {
+    const char* cut = begin + (end - begin) * chunk / num_chunks;
+    cut = std::max(cut, bounds[chunk - 1]);
+    bounds[chunk] = std::min(FindLineEnd(cut, end) + 1, end);
+  }
+
+  std::vector<size_t> offsets(num_chunks + 1, 0);
+  RunChunks(num_chunks, [&](size_t chunk) {
+    offsets[chunk + 1] = CountCsvRecords(bounds[chunk], bounds[chunk + 1]);
+  });
+  for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+    offsets[chunk + 1] += offsets[chunk];
+  }
+
+  particles_.assign(offsets[num_chunks], kEmptyParticle);
+  std::vector<char> succeeded(num_chunks, false);
+  RunChunks(num_chunks, [&](size_t chunk) {
+    succeeded[chunk] =
+        ParseCsvChunk(bounds[chunk], bounds[chunk + 1], species_,
+                      particles_.data() + offsets[chunk]);
+  });
+  if (std::find(succeeded.begin(), succeeded.end(), false) !=
+      succeeded.end()) {
+    particles_.clear();
+    return false;
+  }
+  return true;
+}
+
+bool Scenario::ParseBinary(const char* begin, const char* end, size_t count) {
+  if ((size_t)(end - begin) / kBinaryRecordSize < count) {
+    return false;
+  }
+
+  size_t num_chunks = GetNumChunks(count * kBinaryRecordSize);
+  particles_.assign(count, kEmptyParticle);
+  std::vector<char> succeeded(num_chunks, false);
+  RunChunks(num_chunks, [&](size_t chunk) {
+    size_t first = count * chunk / num_chunks;
+    size_t last = count * (chunk + 1) / num_chunks;
+    succeeded[chunk] =
+        ParseBinaryChunk(begin + first * kBinaryRecordSize, last - first,
+                         species_, particles_.data() + first);
+  });
+  if (std::find(succeeded.begin(), succeeded.end(), false) !=
+      succeeded.end()) {
+    particles_.clear();
+    return false;
+  }
+  return true;
+}
+
+size_t Scenario::GetBoxSize() const {
+  return box_size_;
+}
+
+const SpeciesRegistry& Scenario::GetSpeciesRegistry() const {
+  return species_;
+}
+
+const std::map<SpeciesId, Thermostat>& Scenario::GetThermostats() const {
+  return thermostats_;
+}
+
+const StaticGeometry& Scenario::GetStaticGeometry() const {
+  return geometry_;
+}
+
+const std::vector<Particle>& Scenario::GetParticles() const {
+  return particles_;
+}
+
+void Scenario::ScaleTo(size_t box_size) {
+  if (box_size_ == 0 || box_size == box_size_) {
+    return;
+  }
+  float scale = (float)box_size / box_size_;
+  for (Particle& particle : particles_) {
+    particle = Particle(particle.GetPosition() * scale,
+                        particle.GetVelocity() * scale,
+                        particle.GetRadius() * scale, particle.GetMass(),
+                        particle.GetType());
+  }
+  for (auto& entry : thermostats_) {
+    entry.second.target_temperature *= scale * scale;
+  }
+  // Particles added later take their radius from the species.
+  for (SpeciesId type : species_.GetIds()) {
+    Species species = species_.Get(type);
+    species.radius *= scale;
+    species_.Register(type, species);
+  }
+
+  StaticGeometry geometry;
+  for (const Obstacle& obstacle : geometry_.GetObstacles()) {
+    geometry.AddObstacle(Obstacle{obstacle.start * scale,
+                                  obstacle.end * scale,
+                                  obstacle.radius * scale});
+  }
+  geometry_ = geometry;
+  box_size_ = box_size;
+}
+
+void Scenario::Apply(ParticleEngine* engine) {
+  engine->Clear();
+  engine->ClearThermostats();
+  engine->GetSpeciesRegistry() = species_;
+  for (const auto& entry : thermostats_) {
+    engine->SetThermostat(entry.first, entry.second);
+  }
+  engine->SetStaticGeometry(geometry_);
+  engine->AddParticles(&particles_);
+}
+
+}  // namespace idealgas
@@ -0,0 +1,122 @@
+#include <core/shared_state_publisher.h>
+
+#include <algorithm>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace idealgas {
+
+SharedStatePublisher::SharedStatePublisher()
+    : mapping_(nullptr), mapping_size_(0), header_(nullptr), types_(nullptr) {
+}
+
+SharedStatePublisher::~SharedStatePublisher() {
+  Close();
+}
+
+bool SharedStatePublisher::Open(const std::string& name, size_t capacity,
+                                float box_size) {
+#ifdef _WIN32
+  return false;
+#else
+  Close();
+
+  // Removes a segment left behind by a crashed run so readers never see it.
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  size_t size = GetSharedStateSize(capacity);
+  if (ftruncate(fd, (off_t)size) != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the descriptor is closed.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  name_ = name;
+  mapping_ = mapping;
+  mapping_size_ = size;
+
+  char* base = static_cast<char*>(mapping_);
+  header_ = new (base) SharedStateHeader();
+  header_->capacity = capacity;
+  header_->sequence.store(0, std::memory_order_relaxed);
+  header_->step = 0;
+  header_->count = 0;
+  header_->total_count = 0;
+  header_->box_size = box_size;
+  for (size_t column = 0; column < kType; column++) {
+    columns_[column] = reinterpret_cast<float*>(
+        base + GetSharedStateColumnOffset(capacity, (SharedStateColumn)column));
+  }
+  types_ = reinterpret_cast<uint32_t*>(
+      base + GetSharedStateColumnOffset(capacity, kType));
+
+  // Readers only trust a segment once its magic number is set, so it is
+  // written last.
+  header_->version = kSharedStateVersion;
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic = kSharedStateMagic;
+  return true;
+#endif
+}
+
+void SharedStatePublisher::Close() {
+#ifndef _WIN32
+  if (mapping_ == nullptr) {
+    return;
+  }
+  munmap(mapping_, mapping_size_);
+  shm_unlink(name_.c_str());
+  mapping_ = nullptr;
+  header_ = nullptr;
+#endif
+}
+
+bool SharedStatePublisher::IsOpen() const {
+  return mapping_ != nullptr;
+}
+
+void SharedStatePublisher::Publish(const std::vector<Particle>& particles,
+                                   size_t step) {
+  if (header_ == nullptr) {
+    return;
+  }
+
+  // Makes the sequence odd so readers know a write is in progress.
+  uint64_t sequence = header_->sequence.load(std::memory_order_relaxed);
+  header_->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  size_t count = std::min(particles.size(), (size_t)header_->capacity);
+  for (size_t index = 0; index < count; index++) {
+    const Particle& particle = particles[index];
+    columns_[kPositionX][index] = particle.GetPosition().x;
+    columns_[kPositionY][index] = particle.GetPosition().y;
+    columns_[kVelocityX][index] = particle.GetVelocity().x;
+    columns_[kVelocityY][index] = particle.GetVelocity().y;
+    types_[index] = (uint32_t)particle.GetType();
+  }
+  header_->step = step;
+  header_->count = count;
+  header_->total_count = particles.size();
+
+  header_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+}  // namespace idealgas
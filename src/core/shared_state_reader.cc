@@ -0,0 +1,135 @@
+#include <core/shared_state_reader.h>
+
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace idealgas {
+
+SharedStateReader::SharedStateReader() : mapping_(nullptr), mapping_size_(0) {
+}
+
+SharedStateReader::~SharedStateReader() {
+  Close();
+}
+
+bool SharedStateReader::Open(const std::string& name) {
+#ifdef _WIN32
+  return false;
+#else
+  Close();
+
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      (size_t)info.st_size < sizeof(SharedStateHeader)) {
+    close(fd);
+    return false;
+  }
+
+  size_t size = (size_t)info.st_size;
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  const SharedStateHeader* header =
+      static_cast<const SharedStateHeader*>(mapping);
+  bool valid = header->magic == kSharedStateMagic;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  valid = valid && header->version == kSharedStateVersion &&
+          GetSharedStateSize(header->capacity) <= size;
+  if (!valid) {
+    munmap(mapping, size);
+    return false;
+  }
+
+  mapping_ = mapping;
+  mapping_size_ = size;
+  return true;
+#endif
+}
+
+void SharedStateReader::Close() {
+#ifndef _WIN32
+  if (mapping_ == nullptr) {
+    return;
+  }
+  munmap(const_cast<void*>(mapping_), mapping_size_);
+  mapping_ = nullptr;
+#endif
+}
+
+bool SharedStateReader::IsOpen() const {
+  return mapping_ != nullptr;
+}
+
+const SharedStateHeader& SharedStateReader::GetHeader() const {
+  return *static_cast<const SharedStateHeader*>(mapping_);
+}
+
+const float* SharedStateReader::GetColumn(SharedStateColumn column) const {
+  return reinterpret_cast<const float*>(
+      static_cast<const char*>(mapping_) +
+      GetSharedStateColumnOffset(GetHeader().capacity, column));
+}
+
+const uint32_t* SharedStateReader::GetTypes() const {
+  return reinterpret_cast<const uint32_t*>(
+      static_cast<const char*>(mapping_) +
+      GetSharedStateColumnOffset(GetHeader().capacity, kType));
+}
+
+uint64_t SharedStateReader::BeginRead() const {
+  return GetHeader().sequence.load(std::memory_order_acquire);
+}
+
+bool SharedStateReader::EndRead(uint64_t sequence) const {
+  // Keeps the column reads from being moved past the second sequence load.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return sequence % 2 == 0 &&
+         GetHeader().sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+bool SharedStateReader::Read(Snapshot* snapshot, size_t max_attempts) const {
+  const SharedStateHeader& header = GetHeader();
+
+  for (size_t attempt = 0; attempt < max_attempts; attempt++) {
+    uint64_t sequence = BeginRead();
+    if (sequence % 2 != 0) {
+      continue;
+    }
+
+    // A torn read can give any count, so it is clamped before copying.
+    size_t count = std::min((size_t)header.count, (size_t)header.capacity);
+    snapshot->step = header.step;
+    snapshot->total_count = header.total_count;
+    snapshot->box_size = header.box_size;
+    snapshot->position_x.assign(GetColumn(kPositionX),
+                                GetColumn(kPositionX) + count);
+    snapshot->position_y.assign(GetColumn(kPositionY),
+                                GetColumn(kPositionY) + count);
+    snapshot->velocity_x.assign(GetColumn(kVelocityX),
+                                GetColumn(kVelocityX) + count);
+    snapshot->velocity_y.assign(GetColumn(kVelocityY),
+                                GetColumn(kVelocityY) + count);
+    snapshot->type.assign(GetTypes(), GetTypes() + count);
+
+    if (EndRead(sequence)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace idealgas
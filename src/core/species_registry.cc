@@ -0,0 +1,65 @@
+#include <core/species_registry.h>
+
+#include <algorithm>
+
+namespace idealgas {
+
+SpeciesRegistry SpeciesRegistry::CreateDefault() {
+  SpeciesRegistry registry;
+  registry.Register(1, Species{"Particle 1", 1, 5, ci::Color(0, 0, 1)});
+  registry.Register(2, Species{"Particle 2", 5, 5, ci::Color(1, 0, 0)});
+  registry.Register(3, Species{"Particle 3", 7, 5, ci::Color(0, 1, 0)});
+  return registry;
+}
+
+void SpeciesRegistry::Register(SpeciesId id, const Species& species) {
+  if (id >= species_.size()) {
+    species_.resize(id + 1);
+    registered_.resize(id + 1, false);
+  }
+  species_[id] = species;
+  registered_[id] = true;
+}
+
+bool SpeciesRegistry::Contains(SpeciesId id) const {
+  return id < registered_.size() && registered_[id];
+}
+
+const Species& SpeciesRegistry::Get(SpeciesId id) const {
+  return species_[id];
+}
+
+std::vector<SpeciesId> SpeciesRegistry::GetIds() const {
+  std::vector<SpeciesId> ids;
+  for (size_t id = 0; id < registered_.size(); id++) {
+    if (registered_[id]) {
+      ids.push_back((SpeciesId)id);
+    }
+  }
+  return ids;
+}
+
+void SpeciesRegistry::SetRestitution(SpeciesId first, SpeciesId second,
+                                     float restitution) {
+  restitution_[MakePair(first, second)] = restitution;
+}
+
+float SpeciesRegistry::GetRestitution(SpeciesId first,
+                                      SpeciesId second) const {
+  // Most runs set no pairs, so collisions skip the lookup.
+  if (restitution_.empty()) {
+    return 1;
+  }
+  auto it = restitution_.find(MakePair(first, second));
+  if (it == restitution_.end()) {
+    return 1;
+  }
+  return it->second;
+}
+
+std::pair<SpeciesId, SpeciesId> SpeciesRegistry::MakePair(SpeciesId first,
+                                                          SpeciesId second) {
+  return std::make_pair(std::min(first, second), std::max(first, second));
+}
+
+}  // namespace idealgas
@@ -0,0 +1,180 @@
+#include <core/speed_distribution.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace idealgas {
+
+constexpr float SpeedDistribution::kMinSpeed;
+
+SpeedDistribution::SpeedDistribution(double decay, size_t sub_bins_per_octave,
+                                     size_t num_octaves)
+    : decay_(decay),
+      sub_bins_per_octave_(sub_bins_per_octave),
+      num_octaves_(num_octaves),
+      total_count_(0),
+      // One underflow bin, the log-linear bins, and one overflow bin.
+      counts_(2 + sub_bins_per_octave * num_octaves, 0),
+      decayed_counts_(counts_.size(), 0) {
+}
+
+void SpeedDistribution::Add(float speed) {
+  counts_[GetBinIndex(speed)]++;
+  total_count_++;
+}
+
+void SpeedDistribution::AddToBin(size_t bin, size_t count) {
+  if (bin >= counts_.size()) {
+    return;
+  }
+  counts_[bin] += count;
+  total_count_ += count;
+}
+
+void SpeedDistribution::Merge(const SpeedDistribution& other) {
+  for (size_t bin = 0; bin < counts_.size(); bin++) {
+    counts_[bin] += other.counts_[bin];
+  }
+  total_count_ += other.total_count_;
+}
+
+void SpeedDistribution::EndStep() {
+  for (size_t bin = 0; bin < counts_.size(); bin++) {
+    decayed_counts_[bin] =
+        decay_ * decayed_counts_[bin] + (1 - decay_) * counts_[bin];
+  }
+}
+
+void SpeedDistribution::ClearCounts() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  total_count_ = 0;
+}
+
+void SpeedDistribution::Clear() {
+  ClearCounts();
+  std::fill(decayed_counts_.begin(), decayed_counts_.end(), 0);
+}
+
+size_t SpeedDistribution::GetNumBins() const {
+  return counts_.size();
+}
+
+size_t SpeedDistribution::GetBinIndex(float speed) const {
+  // Also catches NaN, which fails every comparison.
+  if (!(speed >= kMinSpeed)) {
+    return 0;
+  }
+
+  // frexp splits speed / kMinSpeed into mantissa * 2^exponent with the
+  // mantissa in [0.5, 1), so exponent - 1 is the octave.
+  int exponent;
+  float mantissa = std::frexp(speed / kMinSpeed, &exponent);
+  size_t octave = (size_t)(exponent - 1);
+  if (octave >= num_octaves_) {
+    return counts_.size() - 1;
+  }
+
+  size_t sub_bin = (size_t)((2 * mantissa - 1) * sub_bins_per_octave_);
+  return 1 + octave * sub_bins_per_octave_ + sub_bin;
+}
+
+float SpeedDistribution::GetBinLowerEdge(size_t bin) const {
+  if (bin == 0) {
+    return 0;
+  }
+  size_t octave = (bin - 1) / sub_bins_per_octave_;
+  size_t sub_bin = (bin - 1) % sub_bins_per_octave_;
+  return std::ldexp(kMinSpeed, (int)octave) *
+         (1 + (float)sub_bin / sub_bins_per_octave_);
+}
+
+float SpeedDistribution::GetBinUpperEdge(size_t bin) const {
+  if (bin == counts_.size() - 1) {
+    return std::numeric_limits<float>::infinity();
+  }
+  return GetBinLowerEdge(bin + 1);
+}
+
+const std::vector<size_t>& SpeedDistribution::GetCounts() const {
+  return counts_;
+}
+
+const std::vector<double>& SpeedDistribution::GetDecayedCounts() const {
+  return decayed_counts_;
+}
+
+size_t SpeedDistribution::GetTotalCount() const {
+  return total_count_;
+}
+
+double SpeedDistribution::CountInRange(float lower, float upper,
+                                       bool decayed) const {
+  return decayed ? CountInRange(decayed_counts_, lower, upper)
+                 : CountInRange(counts_, lower, upper);
+}
+
+float SpeedDistribution::Quantile(double fraction, bool decayed) const {
+  return decayed ? Quantile(decayed_counts_, fraction)
+                 : Quantile(counts_, fraction);
+}
+
+template <typename T>
+double SpeedDistribution::CountInRange(const std::vector<T>& counts,
+                                       float lower, float upper) const {
+  double sum = 0;
+  for (size_t bin = 0; bin < counts.size(); bin++) {
+    if (counts[bin] == 0) {
+      continue;
+    }
+    float bin_lower = GetBinLowerEdge(bin);
+    float bin_upper = GetBinUpperEdge(bin);
+
+    if (std::isinf(bin_upper)) {
+      // Speeds in the overflow bin have no known spread, so they are all
+      // counted at its lower edge.
+      if (bin_lower >= lower && bin_lower < upper) {
+        sum += counts[bin];
+      }
+      continue;
+    }
+
+    float overlap = std::min(upper, bin_upper) - std::max(lower, bin_lower);
+    if (overlap > 0) {
+      sum += counts[bin] * overlap / (bin_upper - bin_lower);
+    }
+  }
+  return sum;
+}
+
+template <typename T>
+float SpeedDistribution::Quantile(const std::vector<T>& counts,
+                                  double fraction) const {
+  double total = 0;
+  for (const T& count : counts) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  double target = fraction * total;
+  double seen = 0;
+  for (size_t bin = 0; bin < counts.size(); bin++) {
+    if (counts[bin] == 0 || seen + counts[bin] < target) {
+      seen += counts[bin];
+      continue;
+    }
+    float bin_lower = GetBinLowerEdge(bin);
+    float bin_upper = GetBinUpperEdge(bin);
+    if (std::isinf(bin_upper)) {
+      return bin_lower;
+    }
+    // Interpolates linearly within the bin holding the target rank.
+    return bin_lower + (float)((target - seen) / counts[bin]) *
+                           (bin_upper - bin_lower);
+  }
+  return GetBinLowerEdge(counts.size() - 1);
+}
+
+}  // namespace idealgas
@@ -0,0 +1,245 @@
+#include <core/static_geometry.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace idealgas {
+
+namespace {
+
+const float kNever = std::numeric_limits<float>::infinity();
+const size_t kMaxLeafSize = 4;
+
+/**
+ * Returns how long until a moving circle touches a fixed point, or kNever if
+ * it is not moving towards it.
+ * @param position The center of the circle relative to the point.
+ */
+float TimeToPoint(const glm::vec2& position, const glm::vec2& velocity,
+                  float radius) {
+  float approach = glm::dot(position, velocity);
+  if (approach >= 0) {
+    return kNever;
+  }
+  float gap = glm::dot(position, position) - radius * radius;
+  if (gap <= 0) {
+    return 0;
+  }
+  float discriminant = approach * approach - glm::dot(velocity, velocity) * gap;
+  if (discriminant < 0) {
+    return kNever;
+  }
+  return gap / (std::sqrt(discriminant) - approach);
+}
+
+}  // namespace
+
+void StaticGeometry::AddSegment(const glm::vec2& start, const glm::vec2& end) {
+  AddObstacle(Obstacle{start, end, 0});
+}
+
+void StaticGeometry::AddCircle(const glm::vec2& center, float radius) {
+  AddObstacle(Obstacle{center, center, radius});
+}
+
+void StaticGeometry::AddObstacle(const Obstacle& obstacle) {
+  obstacles_.push_back(obstacle);
+}
+
+bool StaticGeometry::Load(std::istream& input) {
+  std::string line;
+  bool succeeded = true;
+  while (succeeded && std::getline(input, line)) {
+    std::istringstream fields(line);
+    std::string kind;
+    if (!(fields >> kind) || kind[0] == '#') {
+      continue;
+    }
+
+    if (kind == "segment") {
+      Obstacle obstacle{glm::vec2(), glm::vec2(), 0};
+      float thickness = 0;
+      fields >> obstacle.start.x >> obstacle.start.y >> obstacle.end.x >>
+          obstacle.end.y;
+      succeeded = !fields.fail();
+      if (succeeded && !(fields >> thickness).fail()) {
+        obstacle.radius = thickness / 2;
+      }
+      if (succeeded) {
+        AddObstacle(obstacle);
+      }
+    } else if (kind == "circle") {
+      glm::vec2 center;
+      float radius;
+      fields >> center.x >> center.y >> radius;
+      succeeded = !fields.fail();
+      if (succeeded) {
+        AddCircle(center, radius);
+      }
+    } else {
+      succeeded = false;
+    }
+  }
+  Build();
+  return succeeded;
+}
+
+void StaticGeometry::Build() {
+  size_t num_obstacles = obstacles_.size();
+  obstacle_min_.resize(num_obstacles);
+  obstacle_max_.resize(num_obstacles);
+  order_.resize(num_obstacles);
+  for (size_t index = 0; index < num_obstacles; index++) {
+    const Obstacle& obstacle = obstacles_[index];
+    glm::vec2 radius(obstacle.radius, obstacle.radius);
+    obstacle_min_[index] = glm::min(obstacle.start, obstacle.end) - radius;
+    obstacle_max_[index] = glm::max(obstacle.start, obstacle.end) + radius;
+    order_[index] = (uint32_t)index;
+  }
+
+  nodes_.clear();
+  if (num_obstacles > 0) {
+    nodes_.reserve(2 * num_obstacles / kMaxLeafSize + 1);
+    nodes_.push_back(Node());
+    BuildNode(0, 0, num_obstacles);
+  }
+}
+
+void StaticGeometry::BuildNode(size_t node, size_t first, size_t count) {
+  glm::vec2 min = obstacle_min_[order_[first]];
+  glm::vec2 max = obstacle_max_[order_[first]];
+  for (size_t position = first + 1; position < first + count; position++) {
+    min = glm::min(min, obstacle_min_[order_[position]]);
+    max = glm::max(max, obstacle_max_[order_[position]]);
+  }
+  nodes_[node].min = min;
+  nodes_[node].max = max;
+  if (count <= kMaxLeafSize) {
+    nodes_[node].first = (uint32_t)first;
+    nodes_[node].count = (uint32_t)count;
+    return;
+  }
+
+  // Splits at the median center along the longest side, which keeps the
+  // tree balanced however the obstacles are clustered.
+  bool split_x = max.x - min.x >= max.y - min.y;
+  auto center = [&](uint32_t index) {
+    glm::vec2 sum = obstacle_min_[index] + obstacle_max_[index];
+    return split_x ? sum.x : sum.y;
+  };
+  size_t half = count / 2;
+  std::nth_element(order_.begin() + first, order_.begin() + first + half,
+                   order_.begin() + first + count,
+                   [&](uint32_t first_index, uint32_t second_index) {
+                     return center(first_index) < center(second_index);
+                   });
+
+  size_t children = nodes_.size();
+  nodes_.push_back(Node());
+  nodes_.push_back(Node());
+  nodes_[node].first = (uint32_t)children;
+  nodes_[node].count = 0;
+  BuildNode(children, first, half);
+  BuildNode(children + 1, first + half, count - half);
+}
+
+void StaticGeometry::Clear() {
+  obstacles_.clear();
+  Build();
+}
+
+bool StaticGeometry::IsEmpty() const {
+  return obstacles_.empty();
+}
+
+const std::vector<Obstacle>& StaticGeometry::GetObstacles() const {
+  return obstacles_;
+}
+
+void StaticGeometry::Query(const glm::vec2& min, const glm::vec2& max,
+                           std::vector<size_t>* obstacles) const {
+  if (nodes_.empty()) {
+    return;
+  }
+
+  // The hierarchy is shallow, so a small stack of pending nodes suffices.
+  uint32_t pending[64];
+  size_t num_pending = 0;
+  pending[num_pending++] = 0;
+  while (num_pending > 0) {
+    const Node& node = nodes_[pending[--num_pending]];
+    if (node.min.x > max.x || min.x > node.max.x || node.min.y > max.y ||
+        min.y > node.max.y) {
+      continue;
+    }
+    if (node.count == 0) {
+      pending[num_pending++] = node.first;
+      pending[num_pending++] = node.first + 1;
+      continue;
+    }
+    for (size_t position = node.first; position < node.first + node.count;
+         position++) {
+      uint32_t index = order_[position];
+      if (obstacle_min_[index].x <= max.x && min.x <= obstacle_max_[index].x &&
+          obstacle_min_[index].y <= max.y && min.y <= obstacle_max_[index].y) {
+        obstacles->push_back(index);
+      }
+    }
+  }
+}
+
+glm::vec2 StaticGeometry::GetClosestPoint(const Obstacle& obstacle,
+                                          const glm::vec2& point) {
+  glm::vec2 direction = obstacle.end - obstacle.start;
+  float length_squared = glm::dot(direction, direction);
+  if (length_squared == 0) {
+    return obstacle.start;
+  }
+  float fraction = glm::dot(point - obstacle.start, direction) / length_squared;
+  return obstacle.start +
+         direction * std::min(1.0f, std::max(0.0f, fraction));
+}
+
+float StaticGeometry::GetTimeToContact(const Obstacle& obstacle,
+                                       const glm::vec2& position,
+                                       const glm::vec2& velocity,
+                                       float radius) {
+  float distance = radius + obstacle.radius;
+
+  // The rounded ends behave like fixed circles.
+  float time = std::min(TimeToPoint(position - obstacle.start, velocity, distance),
+                        TimeToPoint(position - obstacle.end, velocity, distance));
+
+  glm::vec2 direction = obstacle.end - obstacle.start;
+  float length_squared = glm::dot(direction, direction);
+  if (length_squared == 0) {
+    return time;
+  }
+
+  // Along the flat sides, the circle approaches the line through the segment
+  // at its speed towards that line.
+  glm::vec2 normal =
+      glm::vec2(-direction.y, direction.x) / std::sqrt(length_squared);
+  float offset = glm::dot(position - obstacle.start, normal);
+  float approach = glm::dot(velocity, normal);
+  if (offset < 0 || (offset == 0 && approach > 0)) {
+    offset = -offset;
+    approach = -approach;
+  }
+  if (approach >= 0) {
+    return time;
+  }
+  float side_time = std::max(0.0f, (offset - distance) / -approach);
+  glm::vec2 contact = position + velocity * side_time;
+  float fraction =
+      glm::dot(contact - obstacle.start, direction) / length_squared;
+  if (fraction >= 0 && fraction <= 1) {
+    time = std::min(time, side_time);
+  }
+  return time;
+}
+
+}  // namespace idealgas
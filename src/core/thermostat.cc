@@ -0,0 +1,92 @@
+#include <core/thermostat.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace idealgas {
+
+float Thermostat::GetVelocityScale(float temperature, float dt) const {
+  // Nothing can be scaled up from rest.
+  if (temperature <= 0) {
+    return 1;
+  }
+
+  // The temperature goes with the square of the velocity.
+  float ratio = target_temperature / temperature;
+  switch (kind) {
+    case ThermostatKind::kRescale:
+      return std::sqrt(ratio);
+    case ThermostatKind::kBerendsen: {
+      // A step longer than the time constant overshoots, so it is capped at
+      // a full rescale.
+      float fraction = coupling > 0 ? std::min(1.0f, dt / coupling) : 1.0f;
+      return std::sqrt(std::max(0.0f, 1 + fraction * (ratio - 1)));
+    }
+    default:
+      return 1;
+  }
+}
+
+float Thermostat::GetResampleProbability(float dt) const {
+  if (kind != ThermostatKind::kAndersen) {
+    return 0;
+  }
+  return std::min(1.0f, std::max(0.0f, coupling * dt));
+}
+
+ThermostatPass::ThermostatPass() : empty_(true), step_(0) {
+}
+
+void ThermostatPass::Clear() {
+  adjustments_.clear();
+  empty_ = true;
+}
+
+void ThermostatPass::AddSpecies(const SpeciesId& type,
+                                const Thermostat& thermostat,
+                                float temperature, float dt) {
+  if (type >= adjustments_.size()) {
+    adjustments_.resize(type + 1, Adjustment{false, 1, 0, 0});
+  }
+  Adjustment& adjustment = adjustments_[type];
+  adjustment.velocity_scale = thermostat.GetVelocityScale(temperature, dt);
+  adjustment.resample_probability = thermostat.GetResampleProbability(dt);
+  adjustment.target_temperature = thermostat.target_temperature;
+  adjustment.active =
+      adjustment.velocity_scale != 1 || adjustment.resample_probability > 0;
+  empty_ = empty_ && !adjustment.active;
+}
+
+void ThermostatPass::SetRandom(const Philox& generator, uint64_t step) {
+  random_ = generator;
+  step_ = step;
+}
+
+bool ThermostatPass::IsEmpty() const {
+  return empty_;
+}
+
+void ThermostatPass::Apply(Particle* particle, size_t index) const {
+  if (particle->GetType() >= adjustments_.size()) {
+    return;
+  }
+  const Adjustment& adjustment = adjustments_[particle->GetType()];
+  if (!adjustment.active) {
+    return;
+  }
+
+  if (adjustment.resample_probability > 0) {
+    Philox::Block words = random_.Generate(index, step_);
+    if (Philox::ToFloat(words[0]) < adjustment.resample_probability) {
+      // Each velocity component of a species at temperature T is normally
+      // distributed with variance T / m.
+      float spread =
+          std::sqrt(adjustment.target_temperature / particle->GetMass());
+      particle->SetVelocity(Philox::ToGaussians(words[1], words[2]) * spread);
+    }
+  } else {
+    particle->SetVelocity(particle->GetVelocity() * adjustment.velocity_scale);
+  }
+}
+
+}  // namespace idealgas
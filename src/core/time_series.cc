@@ -0,0 +1,135 @@
+#include <core/time_series.h>
+
+#include <algorithm>
+
+namespace idealgas {
+
+TimeSeries::TimeSeries(size_t capacity, size_t num_levels, size_t factor)
+    : capacity_(capacity), factor_(factor), levels_(num_levels) {
+  for (Level& level : levels_) {
+    level.ring.resize(capacity_);
+  }
+  Clear();
+}
+
+void TimeSeries::Add(double time, float value) {
+  Sample sample = {time, time, value, value, value};
+  Accumulate(0, sample);
+}
+
+void TimeSeries::Accumulate(size_t level_index, const Sample& sample) {
+  Level& level = levels_[level_index];
+  if (level.pending_count == 0) {
+    level.pending = sample;
+  } else {
+    level.pending.end_time = sample.end_time;
+    level.pending.min = std::min(level.pending.min, sample.min);
+    level.pending.max = std::max(level.pending.max, sample.max);
+    level.pending.mean += sample.mean;
+  }
+  level.pending_count++;
+
+  if (level.pending_count == level.width) {
+    Sample aggregate = level.pending;
+    aggregate.mean /= level.width;
+    level.pending_count = 0;
+    Push(level_index, aggregate);
+  }
+}
+
+void TimeSeries::Push(size_t level_index, const Sample& sample) {
+  Level& level = levels_[level_index];
+  level.ring[level.head] = sample;
+  level.head = (level.head + 1) % capacity_;
+  level.size = std::min(level.size + 1, capacity_);
+
+  if (level_index + 1 < levels_.size()) {
+    Accumulate(level_index + 1, sample);
+  } else if (level.size == capacity_) {
+    CompactLastLevel();
+  }
+}
+
+void TimeSeries::CompactLastLevel() {
+  // The last level never wraps, so its samples are in order from index 0.
+  Level& level = levels_.back();
+  size_t num_merged = capacity_ / 2;
+  for (size_t index = 0; index < num_merged; index++) {
+    const Sample& first = level.ring[2 * index];
+    const Sample& second = level.ring[2 * index + 1];
+    level.ring[index] = Sample{first.start_time, second.end_time,
+                               std::min(first.min, second.min),
+                               std::max(first.max, second.max),
+                               (first.mean + second.mean) / 2};
+  }
+
+  // With an odd capacity the unpaired newest sample starts the next pair.
+  if (capacity_ % 2 == 1) {
+    level.pending = level.ring[capacity_ - 1];
+    level.pending.mean *= level.width;
+    level.pending_count = level.width;
+  }
+  level.size = num_merged;
+  level.head = num_merged;
+  level.width *= 2;
+}
+
+std::vector<TimeSeries::Sample> TimeSeries::GetLevel(size_t level_index) const {
+  const Level& level = levels_[level_index];
+  std::vector<Sample> samples;
+  samples.reserve(level.size);
+
+  size_t oldest = (level.head + capacity_ - level.size) % capacity_;
+  for (size_t index = 0; index < level.size; index++) {
+    samples.push_back(level.ring[(oldest + index) % capacity_]);
+  }
+  return samples;
+}
+
+std::vector<TimeSeries::Sample> TimeSeries::Query(double start_time,
+                                                  double end_time,
+                                                  size_t max_points) const {
+  std::vector<Sample> result;
+  for (size_t level_index = 0; level_index < levels_.size(); level_index++) {
+    result.clear();
+    std::vector<Sample> samples = GetLevel(level_index);
+    for (const Sample& sample : samples) {
+      if (sample.end_time >= start_time && sample.start_time <= end_time) {
+        result.push_back(sample);
+      }
+    }
+
+    bool covers_start =
+        !samples.empty() && samples.front().start_time <= start_time;
+    bool is_complete = levels_[level_index].size < capacity_;
+    if ((covers_start || is_complete) && result.size() <= max_points) {
+      break;
+    }
+  }
+  return result;
+}
+
+void TimeSeries::WriteCsv(std::ostream& out, const std::string& name,
+                          double start_time, double end_time,
+                          size_t max_points) const {
+  for (const Sample& sample : Query(start_time, end_time, max_points)) {
+    out << name << ',' << sample.start_time << ',' << sample.end_time << ','
+        << sample.min << ',' << sample.max << ',' << sample.mean << '\n';
+  }
+}
+
+size_t TimeSeries::GetNumLevels() const {
+  return levels_.size();
+}
+
+void TimeSeries::Clear() {
+  for (size_t index = 0; index < levels_.size(); index++) {
+    Level& level = levels_[index];
+    level.head = 0;
+    level.size = 0;
+    level.pending_count = 0;
+    level.width = index == 0 ? 1 : factor_;
+  }
+}
+
+}  // namespace idealgas
@@ -0,0 +1,179 @@
+#include <core/transport.h>
+
+#include <cstdint>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace idealgas {
+
+namespace {
+
+#ifndef _WIN32
+/**
+ * A transport over one connected socket per peer.
+ */
+class SocketTransport : public Transport {
+ public:
+  SocketTransport(size_t rank, const std::vector<int>& sockets)
+      : rank_(rank), sockets_(sockets) {
+  }
+
+  ~SocketTransport() override {
+    for (int fd : sockets_) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+
+  size_t GetRank() const override {
+    return rank_;
+  }
+
+  size_t GetNumRanks() const override {
+    return sockets_.size();
+  }
+
+  bool Exchange(size_t peer, const std::vector<char>& message,
+                std::vector<char>* reply) override {
+    int fd = sockets_[peer];
+    if (fd < 0) {
+      return false;
+    }
+
+    // Each message is sent with its length in front of it.
+    std::vector<char> outgoing(sizeof(uint64_t) + message.size());
+    uint64_t length = message.size();
+    std::memcpy(outgoing.data(), &length, sizeof(length));
+    std::memcpy(outgoing.data() + sizeof(length), message.data(),
+                message.size());
+
+    // Sending and receiving are interleaved so two peers sending large
+    // messages to each other cannot both block on a full socket buffer.
+    size_t sent = 0;
+    uint64_t incoming_length = 0;
+    size_t header_received = 0;
+    size_t received = 0;
+    bool has_header = false;
+    reply->clear();
+
+    while (sent < outgoing.size() || !has_header ||
+           received < incoming_length) {
+      pollfd request;
+      request.fd = fd;
+      request.events = (short)((sent < outgoing.size() ? POLLOUT : 0) |
+                               ((!has_header || received < incoming_length)
+                                    ? POLLIN
+                                    : 0));
+      request.revents = 0;
+      if (poll(&request, 1, -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      if ((request.revents & (POLLERR | POLLNVAL)) != 0) {
+        return false;
+      }
+
+      if ((request.revents & POLLOUT) != 0) {
+        ssize_t count = send(fd, outgoing.data() + sent,
+                             outgoing.size() - sent, 0);
+        if (count < 0 && errno != EAGAIN && errno != EINTR) {
+          return false;
+        }
+        sent += count > 0 ? (size_t)count : 0;
+      }
+
+      if ((request.revents & (POLLIN | POLLHUP)) != 0) {
+        ssize_t count;
+        if (!has_header) {
+          char* header = reinterpret_cast<char*>(&incoming_length);
+          count = recv(fd, header + header_received,
+                       sizeof(incoming_length) - header_received, 0);
+          if (count > 0) {
+            header_received += (size_t)count;
+            if (header_received == sizeof(incoming_length)) {
+              has_header = true;
+              reply->resize(incoming_length);
+            }
+          }
+        } else {
+          count = recv(fd, reply->data() + received,
+                       incoming_length - received, 0);
+          received += count > 0 ? (size_t)count : 0;
+        }
+        if (count == 0 || (count < 0 && errno != EAGAIN && errno != EINTR)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+ private:
+  size_t rank_;
+  std::vector<int> sockets_;
+};
+#endif
+
+}  // namespace
+
+LocalSocketMesh::LocalSocketMesh(size_t num_ranks)
+    : num_ranks_(num_ranks),
+      sockets_(num_ranks, std::vector<int>(num_ranks, -1)) {
+#ifndef _WIN32
+  for (size_t rank = 0; rank < num_ranks_; rank++) {
+    for (size_t peer = rank + 1; peer < num_ranks_; peer++) {
+      int pair[2];
+      if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        continue;
+      }
+      fcntl(pair[0], F_SETFL, O_NONBLOCK);
+      fcntl(pair[1], F_SETFL, O_NONBLOCK);
+      sockets_[rank][peer] = pair[0];
+      sockets_[peer][rank] = pair[1];
+    }
+  }
+#endif
+}
+
+LocalSocketMesh::~LocalSocketMesh() {
+#ifndef _WIN32
+  for (const std::vector<int>& row : sockets_) {
+    for (int fd : row) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+#endif
+}
+
+std::unique_ptr<Transport> LocalSocketMesh::CreateTransport(size_t rank) {
+#ifdef _WIN32
+  return std::unique_ptr<Transport>();
+#else
+  std::vector<int> own_sockets = sockets_[rank];
+  for (std::vector<int>& row : sockets_) {
+    for (int& fd : row) {
+      // The rank's own sockets now belong to the transport, and the rest are
+      // closed so peers see a hang up if this process exits.
+      if (&row != &sockets_[rank] && fd >= 0) {
+        close(fd);
+      }
+      fd = -1;
+    }
+  }
+  return std::unique_ptr<Transport>(new SocketTransport(rank, own_sockets));
+#endif
+}
+
+}  // namespace idealgas
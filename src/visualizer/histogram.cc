@@ -1,20 +1,27 @@
 #include <visualizer/histogram.h>
 #include <visualizer/ideal_gas_simulation_app.h>
 
+#include <limits>
+
 namespace idealgas {
 namespace visualizer {
 
 Histogram::Histogram(const glm::vec2 &top_left_corner, const size_t &width,
-                     const size_t &length, const size_t &particle_type,
-                     const ci::Color &color)
+                     const size_t &length, const SpeciesId &particle_type,
+                     const Species &species)
     : top_left_corner_(top_left_corner),
       width_(width),
       length_(length),
       particle_type_(particle_type),
-      color_(color) {
+      title_(species.name + " Speed Distribution"),
+      color_(species.color) {
+}
+
+const SpeciesId &Histogram::GetType() const {
+  return particle_type_;
 }
 
-void Histogram::Draw(const std::vector<Particle> &particles) const {
+void Histogram::Draw(const SpeedDistribution &distribution) const {
   ci::gl::color(255, 255, 255);
   ci::gl::drawSolidRect(ci::Rectf(
       top_left_corner_, top_left_corner_ + ci::vec2(length_, width_)));
@@ -26,13 +33,14 @@ void Histogram::Draw(const std::vector<Particle> &particles) const {
       1);
 
   DrawLabels();
-  DrawBars(particles);
+  DrawBars(distribution);
+  DrawMedian(distribution);
   // DrawAxisTicks(); // Commented out for performance.
 }
 
 void Histogram::DrawLabels() const {
   ci::gl::drawStringCentered(
-      "Particle " + std::to_string(particle_type_) + " Speed Distribution",
+      title_,
       glm::vec2(length_ / 2, -kMargin) + top_left_corner_, ci::Color("Black"),
       ci::Font("Times New Roman", 20));
 
@@ -89,43 +97,40 @@ void Histogram::DrawAxisTicks() const {
   }
 }
 
-void Histogram::DrawBars(const std::vector<Particle> &particles) const {
-  std::unordered_map<size_t, size_t> frequency;
-
-  // There are kNumTicksX - 1 or 19 separate bins.
-  for (size_t i = 1; i <= kNumTicksX; i++) {
-    frequency[i] = 0;  // Initially populate them as 0
-  }
-
-  for (const Particle &particle : particles) {
-    // Each histogram should only plot particles of it's type
-    if (particle.GetType() == particle_type_) {
-      // Rounds the magnitude of the velocity upwards. Ex: 2.1 -> 3
-      frequency[(size_t)std::ceilf(glm::length(particle.GetVelocity()))]++;
-    }
-  }
-
-  // Draws each bar
+void Histogram::DrawBars(const SpeedDistribution &distribution) const {
   for (size_t index = 0; index < kNumTicksX; index++) {
+    // Bar index covers speeds in [index, index + 1), except the last bar which
+    // collects everything faster so no particle is dropped.
+    float upper = index + 1 == kNumTicksX
+                      ? std::numeric_limits<float>::infinity()
+                      : (float)(index + 1) * kTickIntervalX;
+    double frequency =
+        distribution.CountInRange((float)index * kTickIntervalX, upper, false);
+
     ci::gl::color(color_);
 
     // index * length_ / kNumTicksX is the tick mark it should be on.
     // width_ / (kNumTicksY*kTickIntervalY) is the pixel amount each particle
     // should add to the bar.
     ci::gl::drawSolidRect(ci::Rectf(
-        top_left_corner_ + glm::vec2(index * length_ / kNumTicksX,
-                                     width_ - (frequency[index + 1] * width_ /
-                                               (kNumTicksY * kTickIntervalY))),
+        top_left_corner_ +
+            glm::vec2(index * length_ / kNumTicksX,
+                      width_ - (float)(frequency * width_ /
+                                       (kNumTicksY * kTickIntervalY))),
         top_left_corner_ +
             glm::vec2((index + 1) * length_ / kNumTicksX, width_)));
   }
 
-  size_t sum = 0;
-  for (size_t i = 1; i <= kNumTicksX; i++) {
-    sum += frequency[i];
-  }
-  DrawNumParticles(sum);
+  DrawNumParticles(distribution.GetTotalCount());
+}
+
+void Histogram::DrawMedian(const SpeedDistribution &distribution) const {
+  float median = distribution.Quantile(0.5, true);
+  float x = std::min(median / (kNumTicksX * kTickIntervalX), 1.0f) * length_;
 
+  ci::gl::color(0, 0, 0);
+  ci::gl::drawLine(top_left_corner_ + glm::vec2(x, 0),
+                   top_left_corner_ + glm::vec2(x, width_));
 }
 
 void Histogram::DrawNumParticles(const size_t &num_particles) const {
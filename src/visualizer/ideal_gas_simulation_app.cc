@@ -1,5 +1,9 @@
 #include <visualizer/ideal_gas_simulation_app.h>
 
+#include <cinder/Log.h>
+
+#include <cstdlib>
+#include <fstream>
 #include <random>
 
 namespace idealgas {
@@ -7,73 +11,122 @@ namespace idealgas {
 namespace visualizer {
 
 IdealGasApp::IdealGasApp()
-    : particle_sim_(glm::vec2(kMargin, kMargin * 2), kParticleBoxSize),
-      histogram1_(
-          glm::vec2(kMargin + kParticleBoxSize + kMargin * 2, kMargin * 3),
-          kHistogramWidth, kHistogramLength, 1, kType1Color),
-      histogram2_(
-          glm::vec2(kMargin + kParticleBoxSize + kMargin * 2, kMargin * 7),
-          kHistogramWidth, kHistogramLength, 2, kType2Color),
-      histogram3_(
-          glm::vec2(kMargin + kParticleBoxSize + kMargin * 2, kMargin * 11),
-          kHistogramWidth, kHistogramLength, 3, kType3Color) {
+    : particle_sim_(glm::vec2(kMargin, kMargin * 2), kParticleBoxSize) {
+  // Each run differs unless a seed is given.
+  SetSeed(std::random_device()());
+  particle_sim_.GetSpeciesRegistry() = SpeciesRegistry::CreateDefault();
+  CreateHistograms();
   ci::app::setWindowSize((int)kWindowLength, (int)kWindowWidth);
 }
 
+void IdealGasApp::SetSeed(uint64_t seed) {
+  particle_sim_.SetSeed(seed);
+  rng_ = PhiloxStream(Philox(seed).Split(kSpeciesDraws));
+}
+
+void IdealGasApp::CreateHistograms() {
+  histograms_.clear();
+  const SpeciesRegistry& species = particle_sim_.GetSpeciesRegistry();
+  for (SpeciesId type : species.GetIds()) {
+    if (histograms_.size() == kMaxHistograms) {
+      break;
+    }
+    histograms_.push_back(Histogram(
+        glm::vec2(kMargin + kParticleBoxSize + kMargin * 2,
+                  kMargin * 3 + histograms_.size() * kHistogramSpacing),
+        kHistogramWidth, kHistogramLength, type, species.Get(type)));
+  }
+}
+
+void IdealGasApp::setup() {
+  const std::vector<std::string>& args = getCommandLineArgs();
+  for (size_t index = 1; index + 1 < args.size(); index++) {
+    const std::string& value = args[index + 1];
+    if (args[index] == "--publish" &&
+        !particle_sim_.EnableStatePublishing(value, kPublishCapacity)) {
+      CI_LOG_E("Could not publish state to " << value);
+    } else if (args[index] == "--serve" &&
+               !particle_sim_.EnableFrameStreaming(value)) {
+      CI_LOG_E("Could not stream frames on " << value);
+    } else if (args[index] == "--connect" &&
+               !particle_sim_.ConnectToServer(value)) {
+      CI_LOG_E("Could not connect to " << value);
+    } else if (args[index] == "--seed") {
+      SetSeed(std::strtoull(value.c_str(), nullptr, 10));
+    } else if (args[index] == "--scenario") {
+      Scenario scenario;
+      if (!scenario.Load(value)) {
+        CI_LOG_E("Could not read a scenario from " << value);
+        continue;
+      }
+      particle_sim_.ApplyScenario(&scenario);
+      CreateHistograms();
+    } else if (args[index] == "--obstacles") {
+      std::ifstream scene(value);
+      StaticGeometry geometry;
+      if (!scene || !geometry.Load(scene)) {
+        CI_LOG_E("Could not read obstacles from " << value);
+        continue;
+      }
+      particle_sim_.SetStaticGeometry(geometry);
+    }
+  }
+}
+
 void IdealGasApp::keyDown(ci::app::KeyEvent event) {
-  // Generates a random number from 1 to 3
-  std::random_device dev;
-  std::mt19937 rng(dev());
-  std::uniform_int_distribution<std::mt19937::result_type> dist3(1,3);
-  float mass;
-  size_t type;
+  const SpeciesRegistry& species = particle_sim_.GetSpeciesRegistry();
+  std::vector<SpeciesId> types = species.GetIds();
 
   switch (event.getCode()) {
     case ci::app::KeyEvent::KEY_UP:
-      particle_sim_.AccelerateSimulation();
+      particle_sim_.ScaleTargetTemperature(kTemperatureStep);
       break;
 
     case ci::app::KeyEvent::KEY_DOWN:
-      particle_sim_.DeaccelerateSimulation();
+      particle_sim_.ScaleTargetTemperature(1 / kTemperatureStep);
       break;
 
     case ci::app::KeyEvent::KEY_RETURN:
       // Creates a random particle from the current particle types
-      switch (dist3(rng)) {
-        case 1:
-          mass = kType1Mass;
-          type = 1;
-          break;
-        case 2:
-          mass = kType2Mass;
-          type = 2;
-          break;
-        case 3:
-          mass = kType3Mass;
-          type = 3;
-          break;
+      if (!types.empty()) {
+        particle_sim_.GenerateRandomParticle(
+            types[rng_.NextBits() % types.size()]);
       }
-      particle_sim_.GenerateRandomParticle(kRadius,mass, type);
       break;
 
     case ci::app::KeyEvent::KEY_DELETE:
       particle_sim_.Clear();
       break;
 
-    case ci::app::KeyEvent::KEY_1:
-      particle_sim_.GenerateRandomParticle(kRadius, kType1Mass, 1);
-      break;
-
-    case ci::app::KeyEvent::KEY_2:
-      particle_sim_.GenerateRandomParticle(kRadius, kType2Mass, 2);
+    case ci::app::KeyEvent::KEY_s:
+      ExportObservables();
       break;
 
-    case ci::app::KeyEvent::KEY_3:
-      particle_sim_.GenerateRandomParticle(kRadius, kType3Mass, 3);
+    default:
+      // Digit keys create a particle of the species with that id.
+      if (event.getChar() >= '1' && event.getChar() <= '9' &&
+          species.Contains((SpeciesId)(event.getChar() - '0'))) {
+        particle_sim_.GenerateRandomParticle(
+            (SpeciesId)(event.getChar() - '0'));
+      }
       break;
   }
 }
 
+void IdealGasApp::ExportObservables() const {
+  const ParticleEngine& engine = particle_sim_.GetParticleEngine();
+  double end_time = (double)engine.GetStepCount();
+
+  std::ofstream out(kObservablesFile);
+  out << "observable,start_time,end_time,min,max,mean\n";
+  engine.GetTemperatureHistory().WriteCsv(out, "temperature", 0, end_time,
+                                          kMaxExportedSamples);
+  engine.GetCollisionRateHistory().WriteCsv(out, "collision_rate", 0, end_time,
+                                            kMaxExportedSamples);
+  engine.GetParticleCountHistory().WriteCsv(out, "particle_count", 0, end_time,
+                                            kMaxExportedSamples);
+}
+
 void IdealGasApp::draw() {
   ci::Color8u background_color(255, 246, 148);  // light yellow
   ci::gl::clear(background_color);
@@ -84,17 +137,15 @@ void IdealGasApp::draw() {
 
   ci::gl::drawStringCentered(
       "Number of particles: " +
-          std::to_string(
-              particle_sim_.GetParticleEngine().GetParticles().size()),
+          std::to_string(particle_sim_.GetParticles().size()),
       glm::vec2(kMargin + kParticleBoxSize / 2, kWindowWidth - kMargin),
       ci::Color("Black"), ci::Font("Times New Roman", 30));
 
   particle_sim_.Draw();
 
-  std::vector<Particle> particles = particle_sim_.GetParticleEngine().GetParticles();
-  histogram1_.Draw(particles);
-  histogram2_.Draw(particles);
-  histogram3_.Draw(particles);
+  for (const Histogram& histogram : histograms_) {
+    histogram.Draw(particle_sim_.GetSpeedDistribution(histogram.GetType()));
+  }
 }
 
 void IdealGasApp::update() {
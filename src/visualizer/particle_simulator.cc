@@ -1,4 +1,3 @@
-#include <cinder/Rand.h>
 #include <visualizer/ideal_gas_simulation_app.h>
 
 namespace idealgas {
@@ -24,15 +23,26 @@ void ParticleSimulator::Draw() const {
       top_left_corner_,
       top_left_corner_ + ci::vec2(num_pixels_per_side_, num_pixels_per_side_)),1);
 
+  // Render the obstacles, with a circle at each rounded end.
+  ci::gl::color(kObstacleColor);
+  const StaticGeometry& geometry = particle_engine_.GetStaticGeometry();
+  for (const Obstacle& obstacle : geometry.GetObstacles()) {
+    glm::vec2 start = top_left_corner_ + obstacle.start;
+    glm::vec2 end = top_left_corner_ + obstacle.end;
+    ci::gl::drawLine(start, end);
+    if (obstacle.radius > 0) {
+      ci::gl::drawSolidCircle(start, obstacle.radius);
+      ci::gl::drawSolidCircle(end, obstacle.radius);
+    }
+  }
+
   // Render the particles.
-  for (const Particle& particle : particle_engine_.GetParticles()) {
-
-    if (particle.GetMass() == kType1Mass) {
-      ci::gl::color(kType1Color);
-    } else if (particle.GetMass() == kType2Mass) {
-      ci::gl::color(kType2Color);
-    } else if (particle.GetMass() == kType3Mass) {
-      ci::gl::color(kType3Color);
+  const SpeciesRegistry& species = GetSpeciesRegistry();
+  for (const Particle& particle : GetParticles()) {
+    if (species.Contains(particle.GetType())) {
+      ci::gl::color(species.Get(particle.GetType()).color);
+    } else {
+      ci::gl::color(kUnknownSpeciesColor);
     }
 
     ci::gl::drawSolidCircle(top_left_corner_ + particle.GetPosition(),
@@ -47,26 +57,116 @@ void ParticleSimulator::Clear() {
   particle_engine_.Clear();
 }
 
-void ParticleSimulator::GenerateRandomParticle(const float& radius, const float& mass, const size_t& type) {
+void ParticleSimulator::GenerateRandomParticle(const float& radius, const float& mass, const SpeciesId& type) {
   particle_engine_.GenerateRandomParticle(radius, mass, type);
 }
 
-void ParticleSimulator::AccelerateSimulation() {
-  particle_engine_.AccelerateParticles();
+void ParticleSimulator::GenerateRandomParticle(const SpeciesId& type) {
+  particle_engine_.GenerateRandomParticle(type);
+}
+
+SpeciesRegistry& ParticleSimulator::GetSpeciesRegistry() {
+  return particle_engine_.GetSpeciesRegistry();
+}
+
+const SpeciesRegistry& ParticleSimulator::GetSpeciesRegistry() const {
+  return particle_engine_.GetSpeciesRegistry();
+}
+
+void ParticleSimulator::SetStaticGeometry(const StaticGeometry& geometry) {
+  particle_engine_.SetStaticGeometry(geometry);
+}
+
+void ParticleSimulator::ApplyScenario(Scenario* scenario) {
+  scenario->ScaleTo(num_pixels_per_side_);
+  scenario->Apply(&particle_engine_);
+}
+
+void ParticleSimulator::SetSeed(uint64_t seed) {
+  particle_engine_.SetSeed(seed);
+}
+
+bool ParticleSimulator::EnableStatePublishing(const std::string& name,
+                                              size_t capacity) {
+  return particle_engine_.EnableStatePublishing(name, capacity);
+}
+
+void ParticleSimulator::ScaleTargetTemperature(const float& factor) {
+  particle_engine_.ScaleTargetTemperature(factor);
+}
+
+bool ParticleSimulator::EnableFrameStreaming(const std::string& endpoint) {
+  return particle_engine_.EnableFrameStreaming(endpoint);
 }
 
-void ParticleSimulator::DeaccelerateSimulation() {
-  particle_engine_.DeaccelerateParticles();
+bool ParticleSimulator::ConnectToServer(const std::string& endpoint) {
+  return frame_client_.Connect(endpoint);
 }
 
 void ParticleSimulator::Update() {
-  particle_engine_.Update();
+  if (frame_client_.IsConnected()) {
+    ReceiveFrames();
+  } else {
+    particle_engine_.Update();
+  }
+}
+
+void ParticleSimulator::ReceiveFrames() {
+  std::vector<char> bytes;
+  FrameDecoder::Frame frame;
+  bool received = false;
+
+  // Every frame is decoded so no keyframe is missed, but only the newest one
+  // is shown.
+  while (frame_client_.Poll(&bytes)) {
+    received = frame_decoder_.Decode(bytes, &frame) || received;
+  }
+  if (!received) {
+    return;
+  }
+
+  // The remote box may have a different size than the one on screen.
+  float scale = num_pixels_per_side_ / frame.box_size;
+  remote_particles_.clear();
+  for (const Particle& particle : frame.particles) {
+    remote_particles_.push_back(Particle(
+        particle.GetPosition() * scale, particle.GetVelocity(),
+        particle.GetRadius() * scale, particle.GetMass(), particle.GetType()));
+  }
+
+  remote_distributions_.clear();
+  for (const auto& entry : frame.histograms) {
+    SpeedDistribution& distribution = remote_distributions_[entry.first];
+    for (size_t bin = 0; bin < entry.second.size(); bin++) {
+      distribution.AddToBin(bin, entry.second[bin]);
+    }
+    distribution.EndStep();
+  }
 }
 
 const ParticleEngine& ParticleSimulator::GetParticleEngine() const{
   return particle_engine_;
 }
 
+const std::vector<Particle>& ParticleSimulator::GetParticles() const {
+  if (frame_client_.IsConnected()) {
+    return remote_particles_;
+  }
+  return particle_engine_.GetParticles();
+}
+
+const SpeedDistribution& ParticleSimulator::GetSpeedDistribution(
+    const SpeciesId& type) const {
+  if (!frame_client_.IsConnected()) {
+    return particle_engine_.GetSpeedDistribution(type);
+  }
+  auto it = remote_distributions_.find(type);
+  if (it == remote_distributions_.end()) {
+    return kEmptySpeedDistribution;
+  }
+  return it->second;
+}
+
 }  // namespace visualizer
 
 }  // namespace idealgas
@@ -0,0 +1,119 @@
+#include <core/c_api.h>
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+const char* kCheckpointFile = "test_c_api_checkpoint.bin";
+const char* kScenarioFile = "test_c_api_scenario.txt";
+
+/**
+ * Returns the x and y of one particle in a view.
+ */
+const float* At(const idealgas_vec2_view& view, size_t index) {
+  return (const float*)((const char*)view.data + index * view.stride);
+}
+
+}  // namespace
+
+TEST_CASE("C API engines") {
+  idealgas_engine* engine = idealgas_create(400, 11);
+  REQUIRE(idealgas_api_version() == IDEALGAS_API_VERSION);
+
+  SECTION("Spawning") {
+    REQUIRE(idealgas_spawn(engine, 2, 30));
+    REQUIRE(idealgas_particle_count(engine) == 30);
+    REQUIRE_FALSE(idealgas_spawn(engine, 99, 1));
+    REQUIRE_FALSE(idealgas_add_particle(engine, 1, 1, 0, 0, 0, 0, 99));
+    REQUIRE(idealgas_particle_count(engine) == 30);
+
+    idealgas_clear(engine);
+    REQUIRE(idealgas_particle_count(engine) == 0);
+    REQUIRE(idealgas_positions(engine).data == nullptr);
+    REQUIRE(idealgas_positions(engine).count == 0);
+  }
+
+  SECTION("Views read the particles in place") {
+    REQUIRE(idealgas_add_particle(engine, 100, 120, 1.5f, -2, 0, 0, 3));
+    REQUIRE(idealgas_add_particle(engine, 300, 250, 0, 0.5f, 8, 2, 1));
+
+    idealgas_vec2_view positions = idealgas_positions(engine);
+    idealgas_vec2_view velocities = idealgas_velocities(engine);
+    idealgas_type_view types = idealgas_types(engine);
+    REQUIRE(positions.count == 2);
+    REQUIRE(At(positions, 0)[0] == 100);
+    REQUIRE(At(positions, 0)[1] == 120);
+    REQUIRE(At(positions, 1)[0] == 300);
+    REQUIRE(At(velocities, 0)[0] == 1.5f);
+    REQUIRE(At(velocities, 1)[1] == 0.5f);
+    REQUIRE(*types.data == 3);
+    REQUIRE(*(const uint16_t*)((const char*)types.data + types.stride) == 1);
+
+    idealgas_step(engine, 4);
+    REQUIRE(idealgas_step_count(engine) == 4);
+    positions = idealgas_positions(engine);
+    REQUIRE(At(positions, 0)[0] == Approx(106));
+    REQUIRE(At(positions, 0)[1] == Approx(112));
+  }
+
+  SECTION("Stepping in batches matches stepping one at a time") {
+    idealgas_engine* other = idealgas_create(400, 11);
+    REQUIRE(idealgas_spawn(engine, 1, 40));
+    REQUIRE(idealgas_spawn(other, 1, 40));
+    REQUIRE(idealgas_set_thermostat(engine, 1, IDEALGAS_THERMOSTAT_ANDERSEN,
+                                    2, 0.1f));
+    REQUIRE(idealgas_set_thermostat(other, 1, IDEALGAS_THERMOSTAT_ANDERSEN,
+                                    2, 0.1f));
+    REQUIRE_FALSE(idealgas_set_thermostat(other, 1, 7, 2, 0.1f));
+
+    idealgas_step(engine, 25);
+    for (size_t step = 0; step < 25; step++) {
+      idealgas_step(other, 1);
+    }
+    idealgas_vec2_view first = idealgas_velocities(engine);
+    idealgas_vec2_view second = idealgas_velocities(other);
+    for (size_t index = 0; index < first.count; index++) {
+      REQUIRE(At(first, index)[0] == At(second, index)[0]);
+      REQUIRE(At(first, index)[1] == At(second, index)[1]);
+    }
+    REQUIRE(idealgas_temperature(engine, 1) > 0);
+    idealgas_destroy(other);
+  }
+
+  SECTION("Checkpoints") {
+    idealgas_set_time_step(engine, 0.5f);
+    REQUIRE(idealgas_spawn(engine, 2, 20));
+    idealgas_step(engine, 10);
+    REQUIRE(idealgas_save_checkpoint(engine, kCheckpointFile));
+
+    idealgas_engine* resumed = idealgas_create(400, 0);
+    idealgas_set_time_step(resumed, 0.5f);
+    REQUIRE(idealgas_load_checkpoint(resumed, kCheckpointFile));
+    REQUIRE(idealgas_step_count(resumed) == 10);
+    idealgas_step(engine, 10);
+    idealgas_step(resumed, 10);
+    REQUIRE(At(idealgas_positions(resumed), 19)[0] ==
+            At(idealgas_positions(engine), 19)[0]);
+    idealgas_destroy(resumed);
+
+    REQUIRE_FALSE(idealgas_load_checkpoint(engine, "missing_checkpoint.bin"));
+    std::remove(kCheckpointFile);
+  }
+
+  SECTION("Scenarios") {
+    {
+      std::ofstream output(kScenarioFile);
+      output << "box 200\nparticles csv\n50,50,1,0,2\n";
+    }
+    REQUIRE(idealgas_load_scenario(engine, kScenarioFile));
+    std::remove(kScenarioFile);
+    REQUIRE(idealgas_particle_count(engine) == 1);
+    REQUIRE(At(idealgas_positions(engine), 0)[0] == 100);
+    REQUIRE(At(idealgas_velocities(engine), 0)[0] == 2);
+    REQUIRE_FALSE(idealgas_load_scenario(engine, "missing_scenario.txt"));
+  }
+
+  idealgas_destroy(engine);
+}
@@ -0,0 +1,150 @@
+#include <core/domain_engine.h>
+#include <core/particle_engine.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+
+using idealgas::DomainEngine;
+using idealgas::LocalSocketMesh;
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::Transport;
+
+namespace {
+
+const size_t kBoxSize = 300;
+const size_t kNumSteps = 300;
+
+/**
+ * A fixed gas on a jittered grid so every run starts from the same state.
+ * @param rows How many rows of particles to place.
+ * @param columns How many particles to place in each row.
+ * @param radius The particle radius. Dense grids collide in long chains.
+ */
+std::vector<Particle> MakeParticles(size_t rows, size_t columns,
+                                    float radius) {
+  std::vector<Particle> particles;
+  uint32_t state = 12345;
+  float column_spacing = (float)kBoxSize / columns;
+  float row_spacing = (float)kBoxSize / rows;
+  for (size_t row = 0; row < rows; row++) {
+    for (size_t column = 0; column < columns; column++) {
+      state = state * 1664525 + 1013904223;
+      float vx = (float)(state >> 8) / (1 << 24) * 4 - 2;
+      state = state * 1664525 + 1013904223;
+      float vy = (float)(state >> 8) / (1 << 24) * 4 - 2;
+      particles.push_back(Particle(
+          glm::vec2((column + 0.5f) * column_spacing,
+                    (row + 0.5f) * row_spacing),
+          glm::vec2(vx, vy), radius, (float)(1 + (row + column) % 3), 1));
+    }
+  }
+  return particles;
+}
+
+// Runs one rank and returns all particles on rank 0.
+std::vector<std::pair<uint64_t, Particle>> RunRank(
+    Transport* transport, const std::vector<Particle>& particles) {
+  DomainEngine domain(kBoxSize, transport);
+  for (size_t index = 0; index < particles.size(); index++) {
+    domain.AddParticle(index, particles[index]);
+  }
+  for (size_t step = 0; step < kNumSteps; step++) {
+    if (!domain.Update()) {
+      break;
+    }
+  }
+  std::vector<std::pair<uint64_t, Particle>> gathered;
+  domain.Gather(&gathered);
+  return gathered;
+}
+
+// Runs every rank, each but the first in a forked process.
+std::vector<std::pair<uint64_t, Particle>> RunRanks(
+    size_t num_ranks, const std::vector<Particle>& particles) {
+  LocalSocketMesh mesh(num_ranks);
+  std::vector<pid_t> children;
+  for (size_t rank = 1; rank < num_ranks; rank++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      std::unique_ptr<Transport> transport = mesh.CreateTransport(rank);
+      RunRank(transport.get(), particles);
+      _exit(0);
+    }
+    children.push_back(pid);
+  }
+
+  std::unique_ptr<Transport> transport = mesh.CreateTransport(0);
+  std::vector<std::pair<uint64_t, Particle>> gathered =
+      RunRank(transport.get(), particles);
+  for (pid_t pid : children) {
+    int status;
+    waitpid(pid, &status, 0);
+    REQUIRE(WIFEXITED(status));
+  }
+  return gathered;
+}
+
+/**
+ * Returns how many particles differ from a single engine run on the same
+ * particles.
+ */
+size_t CountMismatches(
+    const std::vector<std::pair<uint64_t, Particle>>& gathered,
+    const std::vector<Particle>& particles) {
+  ParticleEngine single_engine(kBoxSize);
+  for (const Particle& particle : particles) {
+    single_engine.AddParticle(particle);
+  }
+  for (size_t step = 0; step < kNumSteps; step++) {
+    single_engine.Update();
+  }
+
+  const std::vector<Particle>& expected = single_engine.GetParticles();
+  REQUIRE(gathered.size() == expected.size());
+  size_t num_mismatches = 0;
+  for (size_t index = 0; index < gathered.size(); index++) {
+    if (gathered[index].first != index ||
+        gathered[index].second.GetPosition() != expected[index].GetPosition() ||
+        gathered[index].second.GetVelocity() != expected[index].GetVelocity()) {
+      num_mismatches++;
+    }
+  }
+  return num_mismatches;
+}
+
+}  // namespace
+
+TEST_CASE("Domain decomposition across processes") {
+  SECTION("A dilute gas matches a single engine") {
+    std::vector<Particle> particles = MakeParticles(5, 6, 5);
+    REQUIRE(CountMismatches(RunRanks(3, particles), particles) == 0);
+  }
+
+  SECTION("Chains of collisions across slab edges match a single engine") {
+    std::vector<Particle> particles = MakeParticles(24, 24, 5.5f);
+    REQUIRE(CountMismatches(RunRanks(4, particles), particles) == 0);
+  }
+
+  SECTION("Any number of ranks gives the same run as one") {
+    std::vector<Particle> particles = MakeParticles(16, 16, 6);
+    std::vector<std::pair<uint64_t, Particle>> one_rank =
+        RunRanks(1, particles);
+    for (size_t num_ranks = 2; num_ranks <= 5; num_ranks++) {
+      std::vector<std::pair<uint64_t, Particle>> many_ranks =
+          RunRanks(num_ranks, particles);
+      REQUIRE(many_ranks.size() == one_rank.size());
+      size_t num_mismatches = 0;
+      for (size_t index = 0; index < one_rank.size(); index++) {
+        if (many_ranks[index].second.GetPosition() !=
+                one_rank[index].second.GetPosition() ||
+            many_ranks[index].second.GetVelocity() !=
+                one_rank[index].second.GetVelocity()) {
+          num_mismatches++;
+        }
+      }
+      REQUIRE(num_mismatches == 0);
+    }
+  }
+}
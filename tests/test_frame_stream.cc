@@ -0,0 +1,177 @@
+#include <core/frame_codec.h>
+#include <core/frame_server.h>
+#include <core/particle_engine.h>
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+using idealgas::FrameClient;
+using idealgas::FrameDecoder;
+using idealgas::FrameEncoder;
+using idealgas::FrameServer;
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::SpeedDistribution;
+
+namespace {
+
+// Polls until a frame arrives or a second passes.
+bool WaitForFrame(FrameClient* client, std::vector<char>* frame) {
+  for (size_t attempt = 0; attempt < 1000; attempt++) {
+    if (client->Poll(frame)) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST_CASE("Frame encoding") {
+  std::vector<Particle> particles = {
+      Particle(glm::vec2(100, 200), glm::vec2(1, 1), 5, 1, 1),
+      Particle(glm::vec2(599, 0), glm::vec2(1, 1), 3, 5, 2)};
+  std::map<idealgas::SpeciesId, SpeedDistribution> distributions;
+  distributions[1].Add(2);
+
+  FrameEncoder encoder(10);
+  FrameDecoder decoder;
+  std::vector<char> keyframe;
+  std::vector<char> delta;
+  FrameDecoder::Frame frame;
+
+  REQUIRE(encoder.Encode(particles, distributions, 1, 600, &keyframe));
+  particles[0] = Particle(glm::vec2(110, 190), glm::vec2(1, 1), 5, 1, 1);
+  REQUIRE_FALSE(encoder.Encode(particles, distributions, 2, 600, &delta));
+
+  SECTION("Deltas need their keyframe") {
+    REQUIRE_FALSE(decoder.Decode(delta, &frame));
+  }
+
+  SECTION("Frames round trip within the quantization step") {
+    REQUIRE(decoder.Decode(keyframe, &frame));
+    REQUIRE(frame.is_keyframe);
+    REQUIRE(decoder.Decode(delta, &frame));
+    REQUIRE_FALSE(frame.is_keyframe);
+    REQUIRE(frame.step == 2);
+    REQUIRE(frame.particles.size() == 2);
+    REQUIRE(frame.particles[0].GetPosition().x == Approx(110).margin(0.01));
+    REQUIRE(frame.particles[0].GetPosition().y == Approx(190).margin(0.01));
+    REQUIRE(frame.particles[1].GetRadius() == 3);
+    REQUIRE(frame.particles[1].GetType() == 2);
+    REQUIRE(frame.histograms[1][distributions[1].GetBinIndex(2)] == 1);
+  }
+
+  SECTION("Frames with too few bytes for their count are refused") {
+    // The particle count follows the magic, kind, keyframe id, step and box.
+    std::vector<char> lying = keyframe;
+    uint32_t count = UINT32_MAX;
+    std::memcpy(lying.data() + 21, &count, sizeof(count));
+    REQUIRE_FALSE(decoder.Decode(lying, &frame));
+
+    std::vector<char> truncated(keyframe.begin(), keyframe.begin() + 30);
+    REQUIRE_FALSE(decoder.Decode(truncated, &frame));
+    REQUIRE_FALSE(decoder.Decode(delta, &frame));
+  }
+
+  SECTION("Refused frames change nothing") {
+    std::vector<char> next_keyframe;
+    encoder.RequestKeyframe();
+    REQUIRE(encoder.Encode(particles, distributions, 3, 600, &next_keyframe));
+    next_keyframe.pop_back();
+
+    REQUIRE(decoder.Decode(keyframe, &frame));
+    REQUIRE_FALSE(decoder.Decode(next_keyframe, &frame));
+    REQUIRE(frame.step == 1);
+    REQUIRE(frame.particles[0].GetPosition().x == Approx(100).margin(0.01));
+    REQUIRE(decoder.Decode(delta, &frame));
+    REQUIRE(frame.step == 2);
+  }
+
+  SECTION("Histograms with more bins than the viewer's are refused") {
+    FrameDecoder small_decoder(distributions[1].GetNumBins() - 1);
+    REQUIRE_FALSE(small_decoder.Decode(keyframe, &frame));
+  }
+
+  SECTION("Deltas are smaller than keyframes") {
+    REQUIRE(delta.size() < keyframe.size());
+  }
+}
+
+TEST_CASE("Frame streaming over loopback") {
+  FrameServer server(4);
+  REQUIRE(server.Listen("127.0.0.1:0"));
+  REQUIRE(server.GetPort() != 0);
+
+  FrameClient client;
+  REQUIRE(client.Connect("127.0.0.1:" + std::to_string(server.GetPort())));
+  REQUIRE(server.AcceptClients());
+  REQUIRE(server.GetNumClients() == 1);
+
+  SECTION("New viewers start at a keyframe") {
+    server.Broadcast(std::vector<char>{'d'}, false);
+    server.Broadcast(std::vector<char>{'k'}, true);
+    std::vector<char> frame;
+    REQUIRE(WaitForFrame(&client, &frame));
+    REQUIRE(frame == std::vector<char>{'k'});
+  }
+
+  SECTION("Slow viewers lose frames instead of stalling the server") {
+    std::vector<char> large_frame(1 << 20, 'x');
+    for (size_t count = 0; count < 64; count++) {
+      server.Broadcast(large_frame, true);
+    }
+    REQUIRE(server.GetDroppedFrames() > 0);
+    REQUIRE(server.GetNumClients() == 1);
+  }
+
+  SECTION("Disconnected viewers are removed") {
+    client.Close();
+    for (size_t count = 0; count < 10 && server.GetNumClients() > 0; count++) {
+      server.Broadcast(std::vector<char>(1024, 'x'), true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(server.GetNumClients() == 0);
+  }
+}
+
+TEST_CASE("Engine streams frames to a Unix socket viewer") {
+  std::string endpoint =
+      "unix:/tmp/ideal_gas_test_" + std::to_string(getpid()) + ".sock";
+  ParticleEngine particle_handler(750);
+  particle_handler.AddParticle(
+      Particle(glm::vec2(100, 100), glm::vec2(3, 4), 5, 1, 1));
+  REQUIRE(particle_handler.EnableFrameStreaming(endpoint));
+
+  FrameClient client;
+  REQUIRE(client.Connect(endpoint));
+  particle_handler.Update();
+
+  std::vector<char> bytes;
+  REQUIRE(WaitForFrame(&client, &bytes));
+  FrameDecoder decoder;
+  FrameDecoder::Frame frame;
+  REQUIRE(decoder.Decode(bytes, &frame));
+  REQUIRE(frame.is_keyframe);
+  REQUIRE(frame.step == 1);
+  REQUIRE(frame.particles[0].GetPosition().x == Approx(103).margin(0.02));
+}
+
+TEST_CASE("Unix socket servers only replace old sockets") {
+  std::string path =
+      "/tmp/ideal_gas_test_" + std::to_string(getpid()) + ".txt";
+  {
+    std::ofstream output(path);
+    output << "not a socket";
+  }
+  FrameServer server;
+  REQUIRE_FALSE(server.Listen("unix:" + path));
+  REQUIRE(std::ifstream(path).good());
+  std::remove(path.c_str());
+}
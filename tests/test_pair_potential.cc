@@ -0,0 +1,121 @@
+#include <core/pair_potential.h>
+#include <core/particle_engine.h>
+
+#include <catch2/catch.hpp>
+#include <cmath>
+
+using idealgas::PairPotential;
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+
+namespace {
+
+double GetKineticEnergy(const std::vector<Particle>& particles) {
+  double energy = 0;
+  for (const Particle& particle : particles) {
+    energy += 0.5 * particle.GetMass() *
+              glm::dot(particle.GetVelocity(), particle.GetVelocity());
+  }
+  return energy;
+}
+
+glm::vec2 GetMomentum(const std::vector<Particle>& particles) {
+  glm::vec2 momentum(0, 0);
+  for (const Particle& particle : particles) {
+    momentum += particle.GetMass() * particle.GetVelocity();
+  }
+  return momentum;
+}
+
+}  // namespace
+
+TEST_CASE("Lennard-Jones table") {
+  PairPotential potential = PairPotential::LennardJones(2, 10, 25);
+  float shift = 8 * (std::pow(0.4f, 12) - std::pow(0.4f, 6));
+
+  SECTION("Matches the formula") {
+    for (float distance : {8.0f, 10.0f, 13.0f, 20.0f}) {
+      float inverse6 = std::pow(10 / distance, 6);
+      float energy = 8 * (inverse6 * inverse6 - inverse6) - shift;
+      float force = 48 * (2 * inverse6 * inverse6 - inverse6) /
+                    (distance * distance);
+      REQUIRE(potential.GetEnergy(distance * distance) ==
+              Approx(energy).epsilon(1e-3).margin(1e-5));
+      REQUIRE(potential.GetForceOverDistance(distance * distance) ==
+              Approx(force).epsilon(1e-3).margin(1e-5));
+    }
+  }
+
+  SECTION("Repels inside the well and attracts outside it") {
+    float well = 10 * std::pow(2.0f, 1.0f / 6);
+    REQUIRE(potential.GetForceOverDistance(std::pow(well - 1, 2)) > 0);
+    REQUIRE(potential.GetForceOverDistance(std::pow(well + 1, 2)) < 0);
+    REQUIRE(potential.GetEnergy(well * well) == Approx(-2 - shift).epsilon(1e-3));
+  }
+
+  SECTION("Nothing beyond the cutoff") {
+    REQUIRE(potential.GetEnergy(25 * 25) == 0);
+    REQUIRE(potential.GetForceOverDistance(30 * 30) == 0);
+    REQUIRE(potential.GetEnergy(24.99f * 24.99f) == Approx(0).margin(1e-4));
+  }
+}
+
+TEST_CASE("Yukawa table") {
+  PairPotential potential = PairPotential::Yukawa(100, 5, 30);
+  float distance = 7;
+  float force = 100 * std::exp(-distance / 5) * (1 / distance + 1.0f / 5) /
+                (distance * distance);
+  REQUIRE(potential.GetForceOverDistance(distance * distance) ==
+          Approx(force).epsilon(1e-3));
+}
+
+TEST_CASE("Pair potential dynamics") {
+  ParticleEngine particle_handler(750);
+  particle_handler.SetPairPotential(PairPotential::LennardJones(1, 10, 25));
+
+  SECTION("Particles at rest attract") {
+    particle_handler.AddParticle(
+        Particle(glm::vec2(300, 300), glm::vec2(0, 0), 5, 1, 1));
+    particle_handler.AddParticle(
+        Particle(glm::vec2(315, 300), glm::vec2(0, 0), 5, 1, 1));
+    particle_handler.Update();
+    REQUIRE(particle_handler.GetParticles()[0].GetVelocity().x > 0);
+    REQUIRE(particle_handler.GetParticles()[1].GetVelocity().x < 0);
+    REQUIRE(particle_handler.GetPotentialEnergy() < 0);
+  }
+
+  SECTION("Energy and momentum are conserved") {
+    particle_handler.SetTimeStep(0.05f);
+    for (size_t index = 0; index < 25; index++) {
+      glm::vec2 position(300 + 12 * (index % 5), 300 + 12 * (index / 5));
+      glm::vec2 velocity((float)(index * 7 % 5) - 2, (float)(index * 3 % 5) - 2);
+      particle_handler.AddParticle(
+          Particle(position, velocity * 0.2f, 5, 1 + index % 2, 1));
+    }
+    particle_handler.Update();
+    double initial_energy = GetKineticEnergy(particle_handler.GetParticles()) +
+                            particle_handler.GetPotentialEnergy();
+    glm::vec2 initial_momentum = GetMomentum(particle_handler.GetParticles());
+
+    for (size_t step = 0; step < 400; step++) {
+      particle_handler.Update();
+    }
+    double energy = GetKineticEnergy(particle_handler.GetParticles()) +
+                    particle_handler.GetPotentialEnergy();
+    glm::vec2 momentum = GetMomentum(particle_handler.GetParticles());
+    REQUIRE(energy == Approx(initial_energy).epsilon(0.01));
+    REQUIRE(momentum.x == Approx(initial_momentum.x).margin(1e-3));
+    REQUIRE(momentum.y == Approx(initial_momentum.y).margin(1e-3));
+  }
+
+  SECTION("Clearing the potential goes back to hard collisions") {
+    particle_handler.ClearPairPotential();
+    particle_handler.AddParticle(
+        Particle(glm::vec2(300, 300), glm::vec2(0, 0), 5, 1, 1));
+    particle_handler.AddParticle(
+        Particle(glm::vec2(315, 300), glm::vec2(0, 0), 5, 1, 1));
+    particle_handler.Update();
+    REQUIRE(particle_handler.GetParticles()[0].GetVelocity() ==
+            glm::vec2(0, 0));
+  }
+}
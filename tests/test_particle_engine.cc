@@ -209,3 +209,75 @@ TEST_CASE("Generating Random Particles") {
     }
   }
 }
+
+TEST_CASE("Continuous collisions") {
+  ParticleEngine particle_handler(750);
+  particle_handler.SetContinuousCollisions(true);
+
+  SECTION("Particles do not pass through each other") {
+    particle_handler.SetTimeStep(100);
+    particle_handler.AddParticle(
+        Particle(glm::vec2(100, 100), glm::vec2(1, 0), 5, 1, 1));
+    particle_handler.AddParticle(
+        Particle(glm::vec2(200, 100), glm::vec2(-1, 0), 5, 1, 1));
+    particle_handler.Update();
+    // They touch after 45 and travel back for the remaining 55.
+    REQUIRE(particle_handler.GetParticles()[0].GetPosition().x == Approx(90));
+    REQUIRE(particle_handler.GetParticles()[1].GetPosition().x == Approx(210));
+    REQUIRE(particle_handler.GetParticles()[0].GetVelocity() ==
+            glm::vec2(-1, 0));
+  }
+
+  SECTION("Particles do not leave the box") {
+    particle_handler.SetTimeStep(3);
+    particle_handler.AddParticle(
+        Particle(glm::vec2(740, 100), glm::vec2(10, 0), 5, 1, 1));
+    particle_handler.Update();
+    REQUIRE(particle_handler.GetParticles()[0].GetPosition().x == Approx(720));
+    REQUIRE(particle_handler.GetParticles()[0].GetVelocity() ==
+            glm::vec2(-10, 0));
+  }
+
+  SECTION("Several collisions in one step") {
+    particle_handler.SetTimeStep(10);
+    particle_handler.AddParticle(
+        Particle(glm::vec2(100, 100), glm::vec2(10, 0), 5, 1, 1));
+    particle_handler.AddParticle(
+        Particle(glm::vec2(120, 100), glm::vec2(0, 0), 5, 1, 1));
+    particle_handler.AddParticle(
+        Particle(glm::vec2(140, 100), glm::vec2(0, 0), 5, 1, 1));
+    particle_handler.Update();
+    REQUIRE(particle_handler.GetParticles()[0].GetPosition().x == Approx(110));
+    REQUIRE(particle_handler.GetParticles()[1].GetPosition().x == Approx(130));
+    REQUIRE(particle_handler.GetParticles()[2].GetPosition().x == Approx(220));
+    REQUIRE(particle_handler.GetCollisionRateHistory().GetLevel(0).back().max ==
+            2);
+  }
+
+  SECTION("Energy is conserved with large timesteps") {
+    particle_handler.SetTimeStep(20);
+    for (size_t count = 0; count < 100; count++) {
+      glm::vec2 position(100 + 60 * (count % 10), 100 + 60 * (count / 10));
+      glm::vec2 velocity((float)(count * 7 % 11) - 5,
+                         (float)(count * 5 % 9) - 4);
+      particle_handler.AddParticle(
+          Particle(position, velocity, 5, 1 + count % 3, 1));
+    }
+    float initial_temperature = 0;
+    for (size_t step = 0; step < 50; step++) {
+      particle_handler.Update();
+      if (step == 0) {
+        initial_temperature =
+            particle_handler.GetTemperatureHistory().GetLevel(0).back().mean;
+      }
+    }
+    REQUIRE(particle_handler.GetTemperatureHistory().GetLevel(0).back().mean ==
+            Approx(initial_temperature).epsilon(1e-3));
+    for (const Particle& particle : particle_handler.GetParticles()) {
+      REQUIRE(particle.GetPosition().x >= 4.99f);
+      REQUIRE(particle.GetPosition().x <= 745.01f);
+      REQUIRE(particle.GetPosition().y >= 4.99f);
+      REQUIRE(particle.GetPosition().y <= 745.01f);
+    }
+  }
+}
@@ -0,0 +1,151 @@
+#include <core/particle_engine.h>
+#include <core/philox.h>
+
+#include <catch2/catch.hpp>
+#include <sstream>
+
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::Philox;
+using idealgas::PhiloxStream;
+using idealgas::SpeciesRegistry;
+using idealgas::Thermostat;
+using idealgas::ThermostatKind;
+
+namespace {
+
+/**
+ * Fills an engine with particles of every default species, held by an
+ * Andersen thermostat so that every step draws random numbers.
+ */
+void SetUpEngine(ParticleEngine* engine) {
+  engine->GetSpeciesRegistry() = SpeciesRegistry::CreateDefault();
+  for (size_t index = 0; index < 60; index++) {
+    engine->GenerateRandomParticle(1 + index % 3);
+  }
+  engine->SetThermostat(2, Thermostat{ThermostatKind::kAndersen, 3, 0.2f});
+}
+
+void RequireSameParticles(const ParticleEngine& first,
+                          const ParticleEngine& second) {
+  REQUIRE(first.GetParticles().size() == second.GetParticles().size());
+  for (size_t index = 0; index < first.GetParticles().size(); index++) {
+    REQUIRE(first.GetParticles()[index].GetPosition() ==
+            second.GetParticles()[index].GetPosition());
+    REQUIRE(first.GetParticles()[index].GetVelocity() ==
+            second.GetParticles()[index].GetVelocity());
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Philox words") {
+  SECTION("Match the reference generator") {
+    // Known answers published with the Random123 library.
+    REQUIRE(Philox(0).Generate(0, 0) ==
+            Philox::Block{{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}});
+    REQUIRE(Philox(UINT64_MAX).Generate(UINT64_MAX, UINT64_MAX) ==
+            Philox::Block{{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}});
+    REQUIRE(Philox(0x299f31d0a4093822).Generate(0x85a308d3243f6a88,
+                                                0x0370734413198a2e) ==
+            Philox::Block{{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}});
+  }
+
+  SECTION("Split generators differ") {
+    Philox generator(7);
+    REQUIRE(generator.Split(0).GetKey() != generator.Split(1).GetKey());
+    REQUIRE(generator.Split(0).GetKey() == Philox(7).Split(0).GetKey());
+  }
+
+  SECTION("Floats and Gaussians") {
+    REQUIRE(Philox::ToFloat(0) == 0);
+    REQUIRE(Philox::ToFloat(UINT32_MAX) < 1);
+
+    PhiloxStream stream(Philox(3));
+    double sum = 0;
+    double sum_of_squares = 0;
+    size_t num_samples = 20000;
+    for (size_t sample = 0; sample < num_samples; sample++) {
+      glm::vec2 pair = Philox::ToGaussians(stream.NextBits(),
+                                           stream.NextBits());
+      sum += pair.x + pair.y;
+      sum_of_squares += pair.x * pair.x + pair.y * pair.y;
+    }
+    REQUIRE(sum / (2 * num_samples) == Approx(0).margin(0.02));
+    REQUIRE(sum_of_squares / (2 * num_samples) == Approx(1).epsilon(0.03));
+  }
+
+  SECTION("Streams resume from a position") {
+    PhiloxStream stream(Philox(5));
+    for (size_t draw = 0; draw < 6; draw++) {
+      stream.NextBits();
+    }
+    PhiloxStream resumed(Philox(5));
+    resumed.SetPosition(stream.GetPosition());
+    for (size_t draw = 0; draw < 10; draw++) {
+      REQUIRE(resumed.NextBits() == stream.NextBits());
+    }
+  }
+}
+
+TEST_CASE("Seeded engines") {
+  SECTION("The same seed gives the same run") {
+    ParticleEngine first(400, 42);
+    ParticleEngine second(400, 42);
+    SetUpEngine(&first);
+    SetUpEngine(&second);
+    for (size_t step = 0; step < 100; step++) {
+      first.Update();
+      second.Update();
+    }
+    RequireSameParticles(first, second);
+  }
+
+  SECTION("Another seed gives another run") {
+    ParticleEngine first(400, 42);
+    ParticleEngine second(400, 43);
+    SetUpEngine(&first);
+    SetUpEngine(&second);
+    REQUIRE(first.GetParticles()[0].GetPosition() !=
+            second.GetParticles()[0].GetPosition());
+  }
+
+  SECTION("A resumed run continues exactly") {
+    ParticleEngine original(400, 9);
+    SetUpEngine(&original);
+    for (size_t step = 0; step < 50; step++) {
+      original.Update();
+    }
+    std::stringstream checkpoint;
+    REQUIRE(original.SaveCheckpoint(checkpoint));
+
+    ParticleEngine resumed(400);
+    SetUpEngine(&resumed);
+    REQUIRE(resumed.LoadCheckpoint(checkpoint));
+    REQUIRE(resumed.GetSeed() == 9);
+    REQUIRE(resumed.GetStepCount() == 50);
+
+    for (size_t step = 0; step < 50; step++) {
+      original.Update();
+      resumed.Update();
+    }
+    original.GenerateRandomParticle(1);
+    resumed.GenerateRandomParticle(1);
+    RequireSameParticles(original, resumed);
+  }
+
+  SECTION("Checkpoints of another box are refused") {
+    ParticleEngine original(400, 9);
+    SetUpEngine(&original);
+    std::stringstream checkpoint;
+    REQUIRE(original.SaveCheckpoint(checkpoint));
+
+    ParticleEngine other(500);
+    REQUIRE_FALSE(other.LoadCheckpoint(checkpoint));
+    REQUIRE(other.GetParticles().empty());
+
+    std::stringstream truncated(checkpoint.str().substr(0, 100));
+    REQUIRE_FALSE(original.LoadCheckpoint(truncated));
+    REQUIRE(original.GetParticles().size() == 60);
+  }
+}
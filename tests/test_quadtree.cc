@@ -0,0 +1,189 @@
+#include <core/collision_grid.h>
+#include <core/particle_engine.h>
+#include <core/quadtree.h>
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <random>
+
+using idealgas::BroadphaseKind;
+using idealgas::CollisionGrid;
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::Quadtree;
+
+namespace {
+
+/**
+ * Returns every box that overlaps the query box, in increasing order.
+ */
+std::vector<size_t> FindOverlaps(const std::vector<glm::vec2>& mins,
+                                 const std::vector<glm::vec2>& maxes,
+                                 const glm::vec2& min, const glm::vec2& max) {
+  std::vector<size_t> items;
+  for (size_t item = 0; item < mins.size(); item++) {
+    if (mins[item].x <= max.x && min.x <= maxes[item].x &&
+        mins[item].y <= max.y && min.y <= maxes[item].y) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+std::vector<size_t> Query(Quadtree* tree, const glm::vec2& min,
+                          const glm::vec2& max) {
+  std::vector<size_t> items;
+  tree->Query(min, max, &items);
+  std::sort(items.begin(), items.end());
+  return items;
+}
+
+}  // namespace
+
+TEST_CASE("Quadtree queries") {
+  // Mostly small boxes crowded into one corner, with a few large ones.
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> corner(0, 100);
+  std::uniform_real_distribution<float> anywhere(-20, 620);
+  std::vector<glm::vec2> mins;
+  std::vector<glm::vec2> maxes;
+  for (size_t item = 0; item < 500; item++) {
+    bool large = item % 25 == 0;
+    glm::vec2 center = large ? glm::vec2(anywhere(rng), anywhere(rng))
+                             : glm::vec2(corner(rng), corner(rng));
+    float extent = large ? 60.0f : 1.0f + item % 3;
+    mins.push_back(center - glm::vec2(extent, extent));
+    maxes.push_back(center + glm::vec2(extent, extent));
+  }
+
+  Quadtree tree;
+  tree.Reset(600, 4, mins.size());
+  for (size_t item = 0; item < mins.size(); item++) {
+    tree.Insert(item, mins[item], maxes[item]);
+  }
+
+  SECTION("Finds exactly the overlapping boxes") {
+    for (size_t item = 0; item < mins.size(); item++) {
+      REQUIRE(Query(&tree, mins[item], maxes[item]) ==
+              FindOverlaps(mins, maxes, mins[item], maxes[item]));
+    }
+    REQUIRE(Query(&tree, glm::vec2(-50, -50), glm::vec2(700, 700)).size() ==
+            mins.size());
+  }
+
+  SECTION("Splits where the boxes are crowded") {
+    REQUIRE(tree.GetNumNodes() > 1);
+    REQUIRE(tree.GetDepth() >= 4);
+  }
+
+  SECTION("Follows updated boxes") {
+    std::uniform_real_distribution<float> step(-3, 3);
+    for (size_t round = 0; round < 20; round++) {
+      for (size_t item = 0; item < mins.size(); item++) {
+        // Some boxes jump across the box, the rest drift.
+        glm::vec2 offset = item % 50 == round
+                               ? glm::vec2(anywhere(rng), anywhere(rng)) -
+                                     mins[item]
+                               : glm::vec2(step(rng), step(rng));
+        mins[item] += offset;
+        maxes[item] += offset;
+        tree.Update(item, mins[item], maxes[item]);
+      }
+    }
+    for (size_t item = 0; item < mins.size(); item++) {
+      REQUIRE(Query(&tree, mins[item], maxes[item]) ==
+              FindOverlaps(mins, maxes, mins[item], maxes[item]));
+    }
+  }
+
+  SECTION("Merges nodes when boxes are removed") {
+    size_t num_nodes = tree.GetNumNodes();
+    for (size_t item = 0; item < mins.size(); item += 2) {
+      tree.Remove(item);
+    }
+    REQUIRE(tree.GetNumNodes() < num_nodes);
+    for (size_t item = 1; item < mins.size(); item += 2) {
+      std::vector<size_t> found = Query(&tree, mins[item], maxes[item]);
+      REQUIRE(std::find(found.begin(), found.end(), item) != found.end());
+      for (size_t other : found) {
+        REQUIRE(other % 2 == 1);
+      }
+    }
+
+    for (size_t item = 1; item < mins.size(); item += 2) {
+      tree.Remove(item);
+    }
+    REQUIRE(tree.GetNumNodes() == 1);
+    REQUIRE(tree.GetDepth() == 0);
+  }
+}
+
+TEST_CASE("Grids of points") {
+  // Zero sized items leave no typical size to fit the cells to.
+  CollisionGrid grid;
+  grid.Reset(600, 0, 2);
+  grid.Insert(0, glm::vec2(10, 10), glm::vec2(10, 10));
+  grid.Insert(1, glm::vec2(590, 590), glm::vec2(590, 590));
+  std::vector<size_t> items;
+  grid.Query(glm::vec2(0, 0), glm::vec2(20, 20), &items);
+  REQUIRE(items == std::vector<size_t>{0});
+
+  grid.Reset(0, 0, 1);
+  grid.Insert(0, glm::vec2(0, 0), glm::vec2(0, 0));
+  items.clear();
+  grid.Query(glm::vec2(0, 0), glm::vec2(0, 0), &items);
+  REQUIRE(items == std::vector<size_t>{0});
+}
+
+TEST_CASE("Engine broadphases") {
+  // Small and large particles, so cells fitted to one size suit the other
+  // badly.
+  ParticleEngine grid_engine(600);
+  ParticleEngine tree_engine(600);
+  tree_engine.SetBroadphase(BroadphaseKind::kQuadtree);
+  REQUIRE(grid_engine.GetBroadphase() == BroadphaseKind::kUniformGrid);
+  REQUIRE(tree_engine.GetBroadphase() == BroadphaseKind::kQuadtree);
+
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> position(40, 560);
+  std::uniform_real_distribution<float> velocity(-2, 2);
+  for (size_t index = 0; index < 300; index++) {
+    float radius = index % 20 == 0 ? 30.0f : 2.0f;
+    Particle particle(glm::vec2(position(rng), position(rng)),
+                      glm::vec2(velocity(rng), velocity(rng)), radius,
+                      radius, 1);
+    grid_engine.AddParticle(particle);
+    tree_engine.AddParticle(particle);
+  }
+
+  SECTION("Overlapping particles collide the same way") {
+    for (size_t step = 0; step < 200; step++) {
+      grid_engine.Update();
+      tree_engine.Update();
+    }
+    REQUIRE(grid_engine.GetCollisionRateHistory().GetLevel(0).back().max > 0);
+    for (size_t index = 0; index < 300; index++) {
+      REQUIRE(tree_engine.GetParticles()[index].GetPosition() ==
+              grid_engine.GetParticles()[index].GetPosition());
+      REQUIRE(tree_engine.GetParticles()[index].GetVelocity() ==
+              grid_engine.GetParticles()[index].GetVelocity());
+    }
+  }
+
+  SECTION("Continuous collisions find the same contacts") {
+    grid_engine.SetContinuousCollisions(true);
+    tree_engine.SetContinuousCollisions(true);
+    grid_engine.SetTimeStep(4);
+    tree_engine.SetTimeStep(4);
+    for (size_t step = 0; step < 5; step++) {
+      grid_engine.Update();
+      tree_engine.Update();
+    }
+    for (size_t index = 0; index < 300; index++) {
+      glm::vec2 expected = grid_engine.GetParticles()[index].GetPosition();
+      glm::vec2 actual = tree_engine.GetParticles()[index].GetPosition();
+      REQUIRE(actual.x == Approx(expected.x).margin(1e-2));
+      REQUIRE(actual.y == Approx(expected.y).margin(1e-2));
+    }
+  }
+}
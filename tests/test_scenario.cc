@@ -0,0 +1,214 @@
+#include <core/scenario.h>
+
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::Scenario;
+using idealgas::ThermostatKind;
+
+namespace {
+
+const char* kScenarioFile = "test_scenario.txt";
+
+void WriteScenario(const std::string& contents) {
+  std::ofstream output(kScenarioFile, std::ios::binary);
+  output << contents;
+}
+
+/**
+ * Appends one binary particle record.
+ */
+void AppendRecord(std::string* contents, float x, float y, float vx, float vy,
+                  float radius, float mass, uint32_t type) {
+  float fields[] = {x, y, vx, vy, radius, mass};
+  char record[28];
+  std::memcpy(record, fields, sizeof(fields));
+  std::memcpy(record + sizeof(fields), &type, sizeof(type));
+  contents->append(record, sizeof(record));
+}
+
+}  // namespace
+
+TEST_CASE("Loading a CSV scenario") {
+  Scenario scenario;
+
+  SECTION("Header and particles") {
+    WriteScenario(
+        "# Two species in an 800 pixel box\n"
+        "box 800\n"
+        "species 4 Argon 40 6 1 0 0\n"
+        "species 7 Helium 4 3 0 0 1\n"
+        "restitution 4 7 0.5\n"
+        "thermostat 4 berendsen 2.5 10\n"
+        "segment 400 0 400 350 4\n"
+        "particles csv\n"
+        "10,20,1.5,-2,4\n"
+        "\n"
+        "# A particle with its own size\n"
+        " 3.25e2 , 1E1 , -0.5 , 0 , 7 , 8 , 9 \r\n"
+        "1,2,3,4,7");
+    REQUIRE(scenario.Load(kScenarioFile));
+    REQUIRE(scenario.GetBoxSize() == 800);
+    REQUIRE(scenario.GetSpeciesRegistry().GetIds() ==
+            std::vector<idealgas::SpeciesId>{4, 7});
+    REQUIRE(scenario.GetSpeciesRegistry().GetRestitution(7, 4) == 0.5f);
+    REQUIRE(scenario.GetThermostats().at(4).kind ==
+            ThermostatKind::kBerendsen);
+    REQUIRE(scenario.GetThermostats().at(4).coupling == 10);
+    REQUIRE(scenario.GetStaticGeometry().GetObstacles().size() == 1);
+
+    const std::vector<Particle>& particles = scenario.GetParticles();
+    REQUIRE(particles.size() == 3);
+    REQUIRE(particles[0].GetPosition() == glm::vec2(10, 20));
+    REQUIRE(particles[0].GetVelocity() == glm::vec2(1.5f, -2));
+    REQUIRE(particles[0].GetRadius() == 6);
+    REQUIRE(particles[0].GetMass() == 40);
+    REQUIRE(particles[1].GetPosition() == glm::vec2(325, 10));
+    REQUIRE(particles[1].GetRadius() == 8);
+    REQUIRE(particles[1].GetMass() == 9);
+    REQUIRE(particles[2].GetType() == 7);
+    REQUIRE(particles[2].GetRadius() == 3);
+  }
+
+  SECTION("Default species") {
+    WriteScenario("box 600\nparticles csv\n5,5,0,0,2\n");
+    REQUIRE(scenario.Load(kScenarioFile));
+    REQUIRE(scenario.GetParticles()[0].GetMass() == 5);
+  }
+
+  SECTION("Malformed files") {
+    WriteScenario("particles csv\n5,5,0,0,2\n");
+    REQUIRE_FALSE(scenario.Load(kScenarioFile));
+
+    WriteScenario("box 600\nparticles csv\n5,5,0,0\n");
+    REQUIRE_FALSE(scenario.Load(kScenarioFile));
+
+    WriteScenario("box 600\nparticles csv\n5,5,0,0,9\n");
+    REQUIRE_FALSE(scenario.Load(kScenarioFile));
+
+    WriteScenario("box 600\nparticles csv\n5,5,0,0,2,1\n");
+    REQUIRE_FALSE(scenario.Load(kScenarioFile));
+
+    WriteScenario("box 600\nrestitution 65535 1 0.5\nparticles csv\n");
+    REQUIRE_FALSE(scenario.Load(kScenarioFile));
+
+    WriteScenario("box 600\ngravity 9.8\nparticles csv\n");
+    REQUIRE_FALSE(scenario.Load(kScenarioFile));
+
+    WriteScenario("box 600\nthermostat 1 nose-hoover 1\nparticles csv\n");
+    REQUIRE_FALSE(scenario.Load(kScenarioFile));
+
+    WriteScenario("box 600\n");
+    REQUIRE_FALSE(scenario.Load(kScenarioFile));
+    REQUIRE(scenario.GetParticles().empty());
+
+    REQUIRE_FALSE(scenario.Load("missing_scenario.txt"));
+  }
+
+  SECTION("Tables larger than a chunk keep their order") {
+    std::ostringstream contents;
+    contents << "box 100000\nparticles csv\n";
+    for (size_t index = 0; index < 200000; index++) {
+      contents << index / 2.0 << ",1," << index % 7 << ",0," << 1 + index % 3
+               << "\n";
+    }
+    WriteScenario(contents.str());
+    REQUIRE(scenario.Load(kScenarioFile));
+
+    const std::vector<Particle>& particles = scenario.GetParticles();
+    REQUIRE(particles.size() == 200000);
+    size_t num_misplaced = 0;
+    for (size_t index = 0; index < particles.size(); index++) {
+      if (particles[index].GetPosition().x != index / 2.0f ||
+          particles[index].GetType() != 1 + index % 3) {
+        num_misplaced++;
+      }
+    }
+    REQUIRE(num_misplaced == 0);
+  }
+
+  std::remove(kScenarioFile);
+}
+
+TEST_CASE("Loading a binary scenario") {
+  Scenario scenario;
+  std::string contents = "box 600\nparticles binary 3\n";
+  AppendRecord(&contents, 1, 2, 3, 4, 0, 0, 1);
+  AppendRecord(&contents, 5, 6, 7, 8, 10, 20, 3);
+  AppendRecord(&contents, 9, 10, 11, 12, 0, 2, 2);
+
+  SECTION("Records") {
+    WriteScenario(contents);
+    REQUIRE(scenario.Load(kScenarioFile));
+    const std::vector<Particle>& particles = scenario.GetParticles();
+    REQUIRE(particles.size() == 3);
+    REQUIRE(particles[0].GetVelocity() == glm::vec2(3, 4));
+    REQUIRE(particles[0].GetRadius() == 5);
+    REQUIRE(particles[1].GetRadius() == 10);
+    REQUIRE(particles[1].GetMass() == 20);
+    REQUIRE(particles[2].GetMass() == 2);
+    REQUIRE(particles[2].GetType() == 2);
+  }
+
+  SECTION("Truncated table") {
+    WriteScenario(contents.substr(0, contents.size() - 1));
+    REQUIRE_FALSE(scenario.Load(kScenarioFile));
+  }
+
+  std::remove(kScenarioFile);
+}
+
+TEST_CASE("Applying a scenario") {
+  WriteScenario(
+      "box 300\n"
+      "species 5 Neon 2 4 1 1 0\n"
+      "thermostat 5 rescale 3\n"
+      "circle 150 150 20\n"
+      "particles csv\n"
+      "50,50,1,0,5\n"
+      "250,250,0,2,5\n");
+  Scenario scenario;
+  REQUIRE(scenario.Load(kScenarioFile));
+  std::remove(kScenarioFile);
+
+  SECTION("Into an engine") {
+    ParticleEngine engine(300);
+    engine.GetSpeciesRegistry() = idealgas::SpeciesRegistry::CreateDefault();
+    engine.GenerateRandomParticle(1);
+    engine.SetThermostat(1, idealgas::Thermostat{ThermostatKind::kRescale,
+                                                 1, 0});
+    engine.SetThermostat(7, idealgas::Thermostat{ThermostatKind::kRescale,
+                                                 1, 0});
+    scenario.Apply(&engine);
+    REQUIRE(scenario.GetParticles().empty());
+    REQUIRE(engine.GetParticles().size() == 2);
+    REQUIRE_FALSE(engine.GetSpeciesRegistry().Contains(1));
+    REQUIRE(engine.GetThermostat(1).kind == ThermostatKind::kNone);
+    REQUIRE(engine.GetThermostat(7).kind == ThermostatKind::kNone);
+    REQUIRE(engine.GetThermostat(5).target_temperature == 3);
+    REQUIRE(engine.GetStaticGeometry().GetObstacles().size() == 1);
+    // (0.5 * 2 * 1 + 0.5 * 2 * 4) / 2 particles.
+    REQUIRE(engine.GetTemperature(5) == Approx(2.5f));
+  }
+
+  SECTION("Scaled to another box") {
+    scenario.ScaleTo(600);
+    REQUIRE(scenario.GetBoxSize() == 600);
+    REQUIRE(scenario.GetParticles()[1].GetPosition() == glm::vec2(500, 500));
+    REQUIRE(scenario.GetParticles()[1].GetVelocity() == glm::vec2(0, 4));
+    REQUIRE(scenario.GetParticles()[1].GetRadius() == 8);
+    REQUIRE(scenario.GetStaticGeometry().GetObstacles()[0].radius == 40);
+    REQUIRE(scenario.GetThermostats().at(5).target_temperature == 12);
+
+    ParticleEngine engine(600);
+    scenario.Apply(&engine);
+    REQUIRE(engine.GetSpeciesRegistry().Get(5).radius == 8);
+    REQUIRE(engine.GetSpeciesRegistry().Get(5).mass == 2);
+  }
+}
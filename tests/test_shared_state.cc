@@ -0,0 +1,60 @@
+#include <core/particle_engine.h>
+#include <core/shared_state_reader.h>
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::SharedStateReader;
+
+TEST_CASE("Shared state publishing") {
+  std::string name = "/ideal_gas_test_" + std::to_string(getpid());
+  ParticleEngine particle_handler(750);
+  particle_handler.AddParticle(
+      Particle(glm::vec2(100, 100), glm::vec2(3, 4), 5, 1, 1));
+  particle_handler.AddParticle(
+      Particle(glm::vec2(300, 200), glm::vec2(-1, 2), 5, 5, 2));
+  particle_handler.AddParticle(
+      Particle(glm::vec2(500, 600), glm::vec2(0, -2), 5, 7, 3));
+  REQUIRE(particle_handler.EnableStatePublishing(name, 2));
+
+  SharedStateReader reader;
+  REQUIRE(reader.Open(name));
+
+  SECTION("Readers see the latest step") {
+    particle_handler.Update();
+    SharedStateReader::Snapshot snapshot;
+    REQUIRE(reader.Read(&snapshot));
+    REQUIRE(snapshot.step == 1);
+    REQUIRE(snapshot.box_size == 750);
+    REQUIRE(snapshot.position_x == std::vector<float>{103, 299});
+    REQUIRE(snapshot.position_y == std::vector<float>{104, 202});
+    REQUIRE(snapshot.velocity_y == std::vector<float>{4, 2});
+    REQUIRE(snapshot.type == std::vector<uint32_t>{1, 2});
+  }
+
+  SECTION("Particles past the capacity are counted but not copied") {
+    SharedStateReader::Snapshot snapshot;
+    REQUIRE(reader.Read(&snapshot));
+    REQUIRE(snapshot.total_count == 3);
+    REQUIRE(snapshot.position_x.size() == 2);
+  }
+
+  SECTION("Zero-copy reads are validated by the sequence number") {
+    uint64_t sequence = reader.BeginRead();
+    float first_x = reader.GetColumn(idealgas::kPositionX)[0];
+    REQUIRE(reader.EndRead(sequence));
+    REQUIRE(first_x == 100);
+
+    sequence = reader.BeginRead();
+    particle_handler.Update();
+    REQUIRE_FALSE(reader.EndRead(sequence));
+  }
+
+  SECTION("Disabling removes the segment") {
+    particle_handler.DisableStatePublishing();
+    SharedStateReader late_reader;
+    REQUIRE_FALSE(late_reader.Open(name));
+  }
+}
@@ -0,0 +1,74 @@
+#include <core/particle_engine.h>
+#include <core/species_registry.h>
+
+#include <catch2/catch.hpp>
+
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::Species;
+using idealgas::SpeciesId;
+using idealgas::SpeciesRegistry;
+
+TEST_CASE("Species registry") {
+  SpeciesRegistry registry = SpeciesRegistry::CreateDefault();
+
+  SECTION("Default species") {
+    REQUIRE(registry.GetIds() == std::vector<SpeciesId>{1, 2, 3});
+    REQUIRE(registry.Get(2).mass == 5);
+    REQUIRE_FALSE(registry.Contains(0));
+    REQUIRE_FALSE(registry.Contains(4));
+  }
+
+  SECTION("Any number of species") {
+    registry.Register(300, Species{"Heavy", 40, 12, ci::Color(1, 1, 0)});
+    REQUIRE(registry.Contains(300));
+    REQUIRE(registry.Get(300).radius == 12);
+    REQUIRE(registry.GetIds().size() == 4);
+  }
+
+  SECTION("Restitution is symmetric and defaults to elastic") {
+    registry.SetRestitution(1, 3, 0.5f);
+    REQUIRE(registry.GetRestitution(3, 1) == 0.5f);
+    REQUIRE(registry.GetRestitution(1, 2) == 1);
+    REQUIRE(registry.GetRestitution(7, 9) == 1);
+  }
+
+  SECTION("Restitution of the largest ids costs one entry") {
+    registry.SetRestitution(65535, 0, 0.25f);
+    REQUIRE(registry.GetRestitution(0, 65535) == 0.25f);
+    REQUIRE(registry.GetRestitution(65535, 65535) == 1);
+  }
+}
+
+TEST_CASE("Per pair restitution") {
+  ParticleEngine particle_handler(750);
+  particle_handler.GetSpeciesRegistry().SetRestitution(1, 1, 0);
+  particle_handler.AddParticle(
+      Particle(glm::vec2(100, 100), glm::vec2(1, 0), 5, 1, 1));
+  particle_handler.AddParticle(
+      Particle(glm::vec2(110, 100), glm::vec2(-1, 0), 5, 1, 1));
+  particle_handler.Update();
+
+  // A perfectly inelastic collision of equal masses stops both particles.
+  REQUIRE(particle_handler.GetParticles()[0].GetVelocity() == glm::vec2(0, 0));
+  REQUIRE(particle_handler.GetParticles()[1].GetVelocity() == glm::vec2(0, 0));
+}
+
+TEST_CASE("Grouping particles by species") {
+  ParticleEngine particle_handler(750);
+  particle_handler.GetSpeciesRegistry() = SpeciesRegistry::CreateDefault();
+  for (SpeciesId type : {3, 1, 2, 1, 3, 1}) {
+    particle_handler.GenerateRandomParticle(type);
+  }
+  particle_handler.SetGroupBySpecies(true);
+  particle_handler.GenerateRandomParticle(2);
+
+  const std::vector<Particle>& particles = particle_handler.GetParticles();
+  for (size_t index = 1; index < particles.size(); index++) {
+    REQUIRE(particles[index - 1].GetType() <= particles[index].GetType());
+  }
+  REQUIRE(particle_handler.GetSpeciesRange(1) == std::make_pair<size_t, size_t>(0, 3));
+  REQUIRE(particle_handler.GetSpeciesRange(2) == std::make_pair<size_t, size_t>(3, 5));
+  REQUIRE(particle_handler.GetSpeciesRange(3) == std::make_pair<size_t, size_t>(5, 7));
+  REQUIRE(particles[4].GetMass() == 5);
+}
@@ -0,0 +1,85 @@
+#include <core/particle_engine.h>
+#include <core/speed_distribution.h>
+
+#include <catch2/catch.hpp>
+
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::SpeedDistribution;
+
+TEST_CASE("Speed distribution binning") {
+  SpeedDistribution distribution;
+
+  SECTION("Bin edges contain their speeds") {
+    for (float speed : {0.5f, 1.0f, 3.7f, 19.9f, 250.0f}) {
+      size_t bin = distribution.GetBinIndex(speed);
+      REQUIRE(distribution.GetBinLowerEdge(bin) <= speed);
+      REQUIRE(distribution.GetBinUpperEdge(bin) > speed);
+    }
+  }
+
+  SECTION("Slow and fast speeds land in the end bins") {
+    REQUIRE(distribution.GetBinIndex(0) == 0);
+    REQUIRE(distribution.GetBinIndex(1e9f) == distribution.GetNumBins() - 1);
+  }
+
+  SECTION("Fast speeds are not dropped") {
+    distribution.Add(35);
+    distribution.Add(1e9f);
+    REQUIRE(distribution.GetTotalCount() == 2);
+    REQUIRE(distribution.CountInRange(19, 1e30f, false) == Approx(2));
+  }
+
+  SECTION("Counts past the last bin are ignored") {
+    distribution.AddToBin(distribution.GetNumBins(), 5);
+    REQUIRE(distribution.GetTotalCount() == 0);
+  }
+}
+
+TEST_CASE("Speed distribution statistics") {
+  SECTION("Quantiles of a uniform spread") {
+    SpeedDistribution distribution;
+    for (size_t speed = 1; speed <= 100; speed++) {
+      distribution.Add((float)speed / 10);
+    }
+    REQUIRE(distribution.Quantile(0.5, false) == Approx(5).epsilon(0.05));
+    REQUIRE(distribution.Quantile(0.9, false) == Approx(9).epsilon(0.05));
+  }
+
+  SECTION("Merging adds counts") {
+    SpeedDistribution first;
+    SpeedDistribution second;
+    first.Add(2);
+    second.Add(2);
+    second.Add(4);
+    first.Merge(second);
+    REQUIRE(first.GetTotalCount() == 3);
+    REQUIRE(first.GetCounts()[first.GetBinIndex(2)] == 2);
+  }
+
+  SECTION("Decayed distribution approaches a steady state") {
+    SpeedDistribution distribution(0.5);
+    for (size_t step = 0; step < 40; step++) {
+      distribution.ClearCounts();
+      distribution.Add(3);
+      distribution.EndStep();
+    }
+    REQUIRE(distribution.CountInRange(0, 100, true) == Approx(1));
+    REQUIRE(distribution.Quantile(0.5, true) == Approx(3).epsilon(0.1));
+  }
+}
+
+TEST_CASE("Engine records speed distributions per type") {
+  ParticleEngine particle_handler(750);
+  particle_handler.AddParticle(
+      Particle(glm::vec2(100, 100), glm::vec2(3, 4), 5, 1, 1));
+  particle_handler.AddParticle(
+      Particle(glm::vec2(300, 300), glm::vec2(30, 40), 5, 1, 2));
+  particle_handler.Update();
+
+  REQUIRE(particle_handler.GetSpeedDistribution(1).GetTotalCount() == 1);
+  REQUIRE(particle_handler.GetSpeedDistribution(2).GetTotalCount() == 1);
+  REQUIRE(particle_handler.GetSpeedDistribution(3).GetTotalCount() == 0);
+  REQUIRE(particle_handler.GetSpeedDistribution(2).Quantile(1, false) ==
+          Approx(50).epsilon(0.1));
+}
@@ -0,0 +1,121 @@
+#include <core/particle_engine.h>
+#include <core/static_geometry.h>
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <sstream>
+
+using idealgas::Obstacle;
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::StaticGeometry;
+
+TEST_CASE("Loading a scene") {
+  StaticGeometry geometry;
+
+  SECTION("Segments and circles") {
+    std::istringstream scene(
+        "# An orifice\n"
+        "segment 300 0 300 280\n"
+        "\n"
+        "segment 300 320 300 600 4\n"
+        "circle 100 100 20\n");
+    REQUIRE(geometry.Load(scene));
+    REQUIRE(geometry.GetObstacles().size() == 3);
+    REQUIRE(geometry.GetObstacles()[1].radius == 2);
+    REQUIRE(geometry.GetObstacles()[2].start == glm::vec2(100, 100));
+    REQUIRE(geometry.GetObstacles()[2].end == glm::vec2(100, 100));
+  }
+
+  SECTION("Malformed lines") {
+    std::istringstream scene(
+        "circle 100 100 20\n"
+        "segment 1 2 3\n"
+        "circle 200 200 20\n");
+    REQUIRE_FALSE(geometry.Load(scene));
+    REQUIRE(geometry.GetObstacles().size() == 1);
+  }
+
+  SECTION("Unknown obstacles") {
+    std::istringstream scene("triangle 0 0 1 1 2 0\n");
+    REQUIRE_FALSE(geometry.Load(scene));
+  }
+}
+
+TEST_CASE("Querying obstacles") {
+  StaticGeometry geometry;
+  for (size_t row = 0; row < 100; row++) {
+    for (size_t column = 0; column < 100; column++) {
+      geometry.AddCircle(glm::vec2(column * 10, row * 10), 1);
+    }
+  }
+  geometry.Build();
+
+  std::vector<size_t> obstacles;
+  geometry.Query(glm::vec2(195, 295), glm::vec2(215, 305), &obstacles);
+  std::sort(obstacles.begin(), obstacles.end());
+  REQUIRE(obstacles == std::vector<size_t>{3020, 3021});
+
+  obstacles.clear();
+  geometry.Query(glm::vec2(-50, -50), glm::vec2(-20, -20), &obstacles);
+  REQUIRE(obstacles.empty());
+}
+
+TEST_CASE("Time to contact with an obstacle") {
+  Obstacle segment{glm::vec2(100, 0), glm::vec2(100, 200), 0};
+
+  SECTION("Flat side") {
+    REQUIRE(StaticGeometry::GetTimeToContact(segment, glm::vec2(50, 100),
+                                             glm::vec2(5, 0), 5) == Approx(9));
+  }
+
+  SECTION("Rounded end") {
+    REQUIRE(StaticGeometry::GetTimeToContact(segment, glm::vec2(100, 250),
+                                             glm::vec2(0, -5), 5) == Approx(9));
+  }
+
+  SECTION("Moving away") {
+    REQUIRE(std::isinf(StaticGeometry::GetTimeToContact(
+        segment, glm::vec2(50, 100), glm::vec2(-5, 0), 5)));
+  }
+
+  SECTION("Passing beside the end") {
+    REQUIRE(std::isinf(StaticGeometry::GetTimeToContact(
+        segment, glm::vec2(50, 300), glm::vec2(5, 0), 5)));
+  }
+}
+
+TEST_CASE("Particles bounce off obstacles") {
+  ParticleEngine particle_handler(750);
+  StaticGeometry geometry;
+  geometry.AddSegment(glm::vec2(100, 0), glm::vec2(100, 750));
+  geometry.AddCircle(glm::vec2(400, 400), 20);
+  particle_handler.SetStaticGeometry(geometry);
+
+  SECTION("Segment") {
+    particle_handler.AddParticle(
+        Particle(glm::vec2(94, 300), glm::vec2(2, 1), 5, 1, 1));
+    particle_handler.Update();
+    REQUIRE(particle_handler.GetParticles()[0].GetVelocity() ==
+            glm::vec2(-2, 1));
+  }
+
+  SECTION("Circle") {
+    particle_handler.AddParticle(
+        Particle(glm::vec2(400, 377), glm::vec2(0, 3), 5, 1, 1));
+    particle_handler.Update();
+    REQUIRE(particle_handler.GetParticles()[0].GetVelocity().y ==
+            Approx(-3));
+  }
+
+  SECTION("Fast particles do not tunnel with continuous collisions") {
+    particle_handler.SetContinuousCollisions(true);
+    particle_handler.SetTimeStep(20);
+    particle_handler.AddParticle(
+        Particle(glm::vec2(50, 300), glm::vec2(5, 0), 5, 1, 1));
+    particle_handler.Update();
+    // Touches the segment after 9 and travels back for 11.
+    REQUIRE(particle_handler.GetParticles()[0].GetPosition().x == Approx(40));
+  }
+}
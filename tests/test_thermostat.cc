@@ -0,0 +1,128 @@
+#include <core/particle_engine.h>
+#include <core/thermostat.h>
+
+#include <catch2/catch.hpp>
+
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::Thermostat;
+using idealgas::ThermostatKind;
+
+namespace {
+
+// Adds particles on a grid far enough apart that none of them collide.
+void AddSpreadOutParticles(ParticleEngine* engine, size_t count,
+                           const glm::vec2& velocity, float mass,
+                           idealgas::SpeciesId type) {
+  for (size_t index = 0; index < count; index++) {
+    glm::vec2 position(100 + 50 * (index % 10), 100 + 50 * (index / 10));
+    engine->AddParticle(Particle(position, velocity, 1, mass, type));
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Thermostat velocity scale") {
+  SECTION("Rescaling reaches the target at once") {
+    Thermostat thermostat{ThermostatKind::kRescale, 4, 0};
+    REQUIRE(thermostat.GetVelocityScale(1, 1) == Approx(2));
+  }
+
+  SECTION("Berendsen relaxes towards the target") {
+    Thermostat thermostat{ThermostatKind::kBerendsen, 4, 10};
+    REQUIRE(thermostat.GetVelocityScale(1, 1) == Approx(std::sqrt(1.3f)));
+    REQUIRE(thermostat.GetVelocityScale(1, 100) == Approx(2));
+  }
+
+  SECTION("Andersen does not scale") {
+    Thermostat thermostat{ThermostatKind::kAndersen, 4, 0.25f};
+    REQUIRE(thermostat.GetVelocityScale(1, 1) == 1);
+    REQUIRE(thermostat.GetResampleProbability(2) == Approx(0.5f));
+  }
+
+  SECTION("A species at rest is left alone") {
+    Thermostat thermostat{ThermostatKind::kRescale, 4, 0};
+    REQUIRE(thermostat.GetVelocityScale(0, 1) == 1);
+  }
+}
+
+TEST_CASE("Thermostatted engine") {
+  ParticleEngine particle_handler(750);
+
+  SECTION("Temperature is tracked as particles are added") {
+    AddSpreadOutParticles(&particle_handler, 10, glm::vec2(1, 1), 2, 1);
+    REQUIRE(particle_handler.GetTemperature(1) == Approx(2));
+    REQUIRE(particle_handler.GetTemperature(2) == 0);
+  }
+
+  SECTION("Rescaling holds one species without touching others") {
+    AddSpreadOutParticles(&particle_handler, 20, glm::vec2(1, 0), 1, 1);
+    AddSpreadOutParticles(&particle_handler, 20, glm::vec2(0, 1), 1, 2);
+    particle_handler.SetThermostat(1, Thermostat{ThermostatKind::kRescale, 2, 0});
+    particle_handler.Update();
+    REQUIRE(particle_handler.GetTemperature(1) == Approx(2));
+    REQUIRE(particle_handler.GetTemperature(2) == Approx(0.5f));
+    REQUIRE(particle_handler.GetParticles()[0].GetVelocity().x == Approx(2));
+  }
+
+  SECTION("Berendsen converges to the target") {
+    AddSpreadOutParticles(&particle_handler, 20, glm::vec2(1, 0), 1, 1);
+    particle_handler.SetThermostat(
+        1, Thermostat{ThermostatKind::kBerendsen, 2, 5});
+    particle_handler.Update();
+    float first_temperature = particle_handler.GetTemperature(1);
+    REQUIRE(first_temperature > 0.5f);
+    REQUIRE(first_temperature < 2);
+    for (size_t step = 0; step < 50; step++) {
+      particle_handler.Update();
+    }
+    REQUIRE(particle_handler.GetTemperature(1) == Approx(2).epsilon(1e-3));
+  }
+
+  SECTION("Andersen draws from the target distribution") {
+    AddSpreadOutParticles(&particle_handler, 100, glm::vec2(0, 0), 3, 1);
+    particle_handler.SetThermostat(
+        1, Thermostat{ThermostatKind::kAndersen, 1, 1});
+    double temperature = 0;
+    for (size_t step = 0; step < 20; step++) {
+      particle_handler.Update();
+      temperature += particle_handler.GetTemperature(1);
+    }
+    REQUIRE(temperature / 20 == Approx(1).epsilon(0.1));
+  }
+
+  SECTION("Removing the thermostat") {
+    AddSpreadOutParticles(&particle_handler, 20, glm::vec2(1, 0), 1, 1);
+    particle_handler.SetThermostat(1, Thermostat{ThermostatKind::kRescale, 2, 0});
+    particle_handler.SetThermostat(1, Thermostat{ThermostatKind::kNone, 0, 0});
+    REQUIRE(particle_handler.GetThermostat(1).kind == ThermostatKind::kNone);
+    particle_handler.Update();
+    REQUIRE(particle_handler.GetTemperature(1) == Approx(0.5f));
+  }
+
+  SECTION("Scaling targets skips species without particles") {
+    particle_handler.GetSpeciesRegistry() =
+        idealgas::SpeciesRegistry::CreateDefault();
+    AddSpreadOutParticles(&particle_handler, 20, glm::vec2(1, 0), 2, 1);
+    particle_handler.ScaleTargetTemperature(2);
+    REQUIRE(particle_handler.GetThermostat(1).target_temperature == 2);
+    REQUIRE(particle_handler.GetThermostat(2).kind == ThermostatKind::kNone);
+
+    // Particles spawned into the empty species afterwards keep moving.
+    for (size_t index = 0; index < 10; index++) {
+      particle_handler.AddParticle(Particle(
+          glm::vec2(125 + 50 * index, 600), glm::vec2(0, 2), 1, 1, 2));
+    }
+    particle_handler.Update();
+    REQUIRE(particle_handler.GetTemperature(1) == Approx(2));
+    REQUIRE(particle_handler.GetTemperature(2) == Approx(2));
+  }
+
+  SECTION("Thermostats also run with continuous collisions") {
+    AddSpreadOutParticles(&particle_handler, 20, glm::vec2(1, 0), 1, 1);
+    particle_handler.SetContinuousCollisions(true);
+    particle_handler.SetThermostat(1, Thermostat{ThermostatKind::kRescale, 2, 0});
+    particle_handler.Update();
+    REQUIRE(particle_handler.GetTemperature(1) == Approx(2));
+  }
+}
@@ -0,0 +1,101 @@
+#include <core/particle_engine.h>
+#include <core/time_series.h>
+
+#include <catch2/catch.hpp>
+#include <sstream>
+
+using idealgas::Particle;
+using idealgas::ParticleEngine;
+using idealgas::TimeSeries;
+
+TEST_CASE("Time series downsampling") {
+  TimeSeries series(16, 3, 10);
+  for (size_t step = 0; step < 1000; step++) {
+    series.Add((double)step, (float)step);
+  }
+
+  SECTION("Raw level keeps only the newest samples") {
+    std::vector<TimeSeries::Sample> raw = series.GetLevel(0);
+    REQUIRE(raw.size() == 16);
+    REQUIRE(raw.front().mean == 984);
+    REQUIRE(raw.back().mean == 999);
+  }
+
+  SECTION("Coarse levels summarise min, max and mean") {
+    std::vector<TimeSeries::Sample> coarse = series.GetLevel(2);
+    REQUIRE(coarse.size() == 10);
+    REQUIRE(coarse.front().start_time == 0);
+    REQUIRE(coarse.front().end_time == 99);
+    REQUIRE(coarse.front().min == 0);
+    REQUIRE(coarse.front().max == 99);
+    REQUIRE(coarse.front().mean == Approx(49.5));
+  }
+
+  SECTION("Queries pick the finest level covering the range") {
+    REQUIRE(series.Query(990, 999, 100).size() == 10);
+    std::vector<TimeSeries::Sample> whole = series.Query(0, 999, 100);
+    REQUIRE(whole.size() == 10);
+    REQUIRE(whole.front().start_time == 0);
+  }
+
+  SECTION("CSV export") {
+    std::ostringstream out;
+    series.WriteCsv(out, "x", 998, 999, 10);
+    REQUIRE(out.str() == "x,998,998,998,998,998\nx,999,999,999,999,999\n");
+  }
+}
+
+TEST_CASE("Time series keep the whole run") {
+  SECTION("The last level merges pairs when full") {
+    TimeSeries series(4, 2, 10);
+    for (size_t step = 0; step < 10000; step++) {
+      series.Add((double)step, (float)step);
+    }
+    std::vector<TimeSeries::Sample> whole = series.GetLevel(1);
+    REQUIRE(whole.size() <= 4);
+    REQUIRE(whole.front().start_time == 0);
+    REQUIRE(whole.front().min == 0);
+    REQUIRE(whole.back().end_time >= 5000);
+
+    // Merged samples are equally wide, so their means average to the mean
+    // of everything they cover.
+    double mean = 0;
+    for (const TimeSeries::Sample& sample : whole) {
+      mean += sample.mean;
+    }
+    REQUIRE(mean / whole.size() == Approx(whole.back().end_time / 2));
+    REQUIRE(series.Query(0, 9999, 4).front().start_time == 0);
+  }
+
+  SECTION("Odd capacities stay contiguous") {
+    TimeSeries series(5, 1, 10);
+    for (size_t step = 0; step < 1000; step++) {
+      series.Add((double)step, (float)step);
+    }
+    std::vector<TimeSeries::Sample> whole = series.GetLevel(0);
+    REQUIRE(whole.front().start_time == 0);
+    for (size_t index = 1; index < whole.size(); index++) {
+      REQUIRE(whole[index].start_time == whole[index - 1].end_time + 1);
+      REQUIRE(whole[index].end_time - whole[index].start_time ==
+              whole[0].end_time - whole[0].start_time);
+    }
+  }
+}
+
+TEST_CASE("Engine records observable histories") {
+  ParticleEngine particle_handler(750);
+  particle_handler.AddParticle(
+      Particle(glm::vec2(100, 100), glm::vec2(3, 4), 5, 2, 1));
+  particle_handler.Update();
+  particle_handler.Update();
+
+  REQUIRE(particle_handler.GetStepCount() == 2);
+  std::vector<TimeSeries::Sample> temperature =
+      particle_handler.GetTemperatureHistory().GetLevel(0);
+  REQUIRE(temperature.size() == 2);
+  REQUIRE(temperature.back().mean == Approx(25));
+  REQUIRE(particle_handler.GetParticleCountHistory().GetLevel(0).back().mean ==
+          1);
+  REQUIRE(particle_handler.GetCollisionRateHistory().GetLevel(0).back().mean ==
+          0);
+}